@@ -0,0 +1,399 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mlog.h"
+#include "mlogformat.h"
+
+namespace {
+
+enum class Output {
+    File,
+    Console,
+    Both
+};
+
+//! How messages are logged
+enum class Api {
+    QtString, //!< qDebug() << QString
+    StdString, //!< qDebug() << std::string
+    Format //!< mlog::debug("{}", std::string), UTF-8 all the way
+};
+
+struct Scenario
+{
+    int threads = 1;
+    int messageSize = 0;
+    //! Messages are logged below current log level
+    bool filtered = false;
+    Output output = Output::File;
+    Api api = Api::QtString;
+};
+
+struct Result
+{
+    Scenario scenario;
+    qint64 messages = 0;
+    double seconds = 0;
+    double messagesPerSecond = 0;
+    qint64 p50 = 0;
+    qint64 p99 = 0;
+    qint64 p999 = 0;
+    qint64 max = 0;
+};
+
+const char *outputName(const Output output)
+{
+    switch (output) {
+    case Output::File:
+        return "file";
+    case Output::Console:
+        return "console";
+    case Output::Both:
+        return "both";
+    }
+    return "";
+}
+
+const char *apiName(const Api api)
+{
+    switch (api) {
+    case Api::QtString:
+        return "qstring";
+    case Api::StdString:
+        return "stdstring";
+    case Api::Format:
+        return "format";
+    }
+    return "";
+}
+
+QVector<int> parseList(const QString &value)
+{
+    QVector<int> result;
+    for (const QString &entry : value.split(QLatin1Char(','))) {
+        bool ok = false;
+        const int number = entry.trimmed().toInt(&ok);
+        if (ok && number >= 0)
+            result.append(number);
+    }
+    return result;
+}
+
+//! Returns \a percentile (0-1) of sorted \a latencies
+qint64 percentile(const std::vector<qint64> &latencies, const double percentile)
+{
+    if (latencies.empty())
+        return 0;
+
+    const std::size_t index = std::min(latencies.size() - 1,
+                                       std::size_t(percentile * double(latencies.size())));
+    return latencies[index];
+}
+
+void configureOutput(const Output output, const QString &directory)
+{
+    if (output == Output::Console)
+        logger()->disableLogToFile();
+    else
+        logger()->enableLogToFile(QStringLiteral("bench"), directory);
+
+    if (output == Output::File)
+        logger()->disableLogToConsole();
+    else
+        logger()->enableLogToConsole();
+}
+
+//! Logs \a messages messages from each of scenario's threads, measuring
+//! latency of every call
+Result run(const Scenario &scenario, const int messages, const QString &directory)
+{
+    configureOutput(scenario.output, directory);
+    logger()->setLogLevel(scenario.filtered ? MLog::WarningLog : MLog::DebugLog);
+
+    const QString payload(scenario.messageSize, QLatin1Char('x'));
+    const std::string stdPayload(std::size_t(scenario.messageSize), 'x');
+    const QLoggingCategory &category = *QLoggingCategory::defaultCategory();
+    std::vector<std::vector<qint64>> latencies(std::size_t(scenario.threads));
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < scenario.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            using clock = std::chrono::steady_clock;
+            std::vector<qint64> &own = latencies[std::size_t(t)];
+            own.reserve(std::size_t(messages));
+            ++ready;
+            while (go.load() == false)
+                std::this_thread::yield();
+
+            for (int i = 0; i < messages; ++i) {
+                const clock::time_point start = clock::now();
+                switch (scenario.api) {
+                case Api::QtString:
+                    qDebug().noquote() << payload;
+                    break;
+                case Api::StdString:
+                    qDebug().noquote() << stdPayload;
+                    break;
+                case Api::Format:
+                    mlog::debug(category, "{}", stdPayload);
+                    break;
+                }
+                const clock::time_point end = clock::now();
+                own.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  end - start).count());
+            }
+        });
+    }
+
+    while (ready.load() < scenario.threads)
+        std::this_thread::yield();
+
+    const auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (std::thread &thread : threads)
+        thread.join();
+    // Asynchronous mode: count the time needed to write everything out
+    logger()->flush();
+    const auto end = std::chrono::steady_clock::now();
+
+    logger()->setLogLevel(MLog::DebugLog);
+    logger()->enableLogToConsole();
+    logger()->disableLogToFile();
+    QFile::remove(logger()->currentLogPath());
+    QFile::remove(logger()->previousLogPath());
+
+    std::vector<qint64> all;
+    all.reserve(std::size_t(messages) * std::size_t(scenario.threads));
+    for (const std::vector<qint64> &own : latencies)
+        all.insert(all.end(), own.begin(), own.end());
+    std::sort(all.begin(), all.end());
+
+    Result result;
+    result.scenario = scenario;
+    result.messages = qint64(all.size());
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.messagesPerSecond = result.seconds > 0 ? double(result.messages) / result.seconds : 0;
+    result.p50 = percentile(all, 0.5);
+    result.p99 = percentile(all, 0.99);
+    result.p999 = percentile(all, 0.999);
+    result.max = all.empty() ? 0 : all.back();
+    return result;
+}
+
+QByteArray toCsv(const QVector<Result> &results)
+{
+    QByteArray csv("threads,message_size,level,output,api,messages,seconds,"
+                   "messages_per_second,p50_ns,p99_ns,p999_ns,max_ns\n");
+    for (const Result &result : results) {
+        csv += QByteArray::number(result.scenario.threads) + ','
+                + QByteArray::number(result.scenario.messageSize) + ','
+                + (result.scenario.filtered ? "filtered" : "accepted") + ','
+                + outputName(result.scenario.output) + ','
+                + apiName(result.scenario.api) + ','
+                + QByteArray::number(result.messages) + ','
+                + QByteArray::number(result.seconds, 'f', 6) + ','
+                + QByteArray::number(result.messagesPerSecond, 'f', 0) + ','
+                + QByteArray::number(result.p50) + ','
+                + QByteArray::number(result.p99) + ','
+                + QByteArray::number(result.p999) + ','
+                + QByteArray::number(result.max) + '\n';
+    }
+    return csv;
+}
+
+QByteArray toJson(const QVector<Result> &results)
+{
+    QJsonArray array;
+    for (const Result &result : results) {
+        QJsonObject object;
+        object.insert(QStringLiteral("threads"), result.scenario.threads);
+        object.insert(QStringLiteral("message_size"), result.scenario.messageSize);
+        object.insert(QStringLiteral("level"), result.scenario.filtered
+                      ? QStringLiteral("filtered") : QStringLiteral("accepted"));
+        object.insert(QStringLiteral("output"),
+                      QLatin1String(outputName(result.scenario.output)));
+        object.insert(QStringLiteral("api"), QLatin1String(apiName(result.scenario.api)));
+        object.insert(QStringLiteral("messages"), result.messages);
+        object.insert(QStringLiteral("seconds"), result.seconds);
+        object.insert(QStringLiteral("messages_per_second"), result.messagesPerSecond);
+        object.insert(QStringLiteral("p50_ns"), result.p50);
+        object.insert(QStringLiteral("p99_ns"), result.p99);
+        object.insert(QStringLiteral("p999_ns"), result.p999);
+        object.insert(QStringLiteral("max_ns"), result.max);
+        array.append(object);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("qt_version"), QLatin1String(qVersion()));
+    root.insert(QStringLiteral("async"), logger()->isAsyncLogging());
+    root.insert(QStringLiteral("results"), array);
+    return QJsonDocument(root).toJson();
+}
+
+}
+
+//! Measures MLog throughput and per call latency, see --help
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("bench_mlog"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                QStringLiteral("Measures MLog throughput (messages per second) and "
+                               "per call latency percentiles. Console output goes "
+                               "to stderr, redirect it to keep the terminal usable."));
+    parser.addHelpOption();
+    const QCommandLineOption threadsOption(
+                { QStringLiteral("t"), QStringLiteral("threads") },
+                QStringLiteral("Comma separated numbers of logging threads "
+                               "(default 1,2,4,8)."),
+                QStringLiteral("list"), QStringLiteral("1,2,4,8"));
+    const QCommandLineOption sizesOption(
+                { QStringLiteral("s"), QStringLiteral("sizes") },
+                QStringLiteral("Comma separated message sizes in characters "
+                               "(default 16,128,1024)."),
+                QStringLiteral("list"), QStringLiteral("16,128,1024"));
+    const QCommandLineOption messagesOption(
+                { QStringLiteral("n"), QStringLiteral("messages") },
+                QStringLiteral("Messages logged by each thread (default 100000)."),
+                QStringLiteral("count"), QStringLiteral("100000"));
+    const QCommandLineOption outputsOption(
+                QStringLiteral("outputs"),
+                QStringLiteral("Comma separated outputs: file, console, both "
+                               "(default file,console,both)."),
+                QStringLiteral("list"), QStringLiteral("file,console,both"));
+    const QCommandLineOption apisOption(
+                QStringLiteral("apis"),
+                QStringLiteral("Comma separated logging APIs: qstring (qDebug() << "
+                               "QString), stdstring (qDebug() << std::string), "
+                               "format (mlog::debug(\"{}\", std::string)) "
+                               "(default qstring)."),
+                QStringLiteral("list"), QStringLiteral("qstring"));
+    const QCommandLineOption asyncOption(
+                QStringLiteral("async"),
+                QStringLiteral("Enable asynchronous logging."));
+    const QCommandLineOption formatOption(
+                { QStringLiteral("f"), QStringLiteral("format") },
+                QStringLiteral("Result format: csv or json (default csv)."),
+                QStringLiteral("format"), QStringLiteral("csv"));
+    const QCommandLineOption resultOption(
+                { QStringLiteral("o"), QStringLiteral("output") },
+                QStringLiteral("Write results to <file> instead of standard output."),
+                QStringLiteral("file"));
+    parser.addOptions({ threadsOption, sizesOption, messagesOption, outputsOption,
+                        apisOption, asyncOption, formatOption, resultOption });
+    parser.process(app);
+
+    const QVector<int> threadCounts = parseList(parser.value(threadsOption));
+    const QVector<int> sizes = parseList(parser.value(sizesOption));
+    const int messages = parser.value(messagesOption).toInt();
+    QVector<Output> outputs;
+    for (const QString &name : parser.value(outputsOption).split(QLatin1Char(','))) {
+        if (name == QLatin1String("file"))
+            outputs.append(Output::File);
+        else if (name == QLatin1String("console"))
+            outputs.append(Output::Console);
+        else if (name == QLatin1String("both"))
+            outputs.append(Output::Both);
+    }
+    QVector<Api> apis;
+    for (const QString &name : parser.value(apisOption).split(QLatin1Char(','))) {
+        if (name == QLatin1String("qstring"))
+            apis.append(Api::QtString);
+        else if (name == QLatin1String("stdstring"))
+            apis.append(Api::StdString);
+        else if (name == QLatin1String("format"))
+            apis.append(Api::Format);
+    }
+    const bool json = parser.value(formatOption) == QLatin1String("json");
+    if (threadCounts.isEmpty() || sizes.isEmpty() || outputs.isEmpty() || apis.isEmpty()
+            || messages <= 0)
+        parser.showHelp(1);
+
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        fprintf(stderr, "Could not create temporary directory\n");
+        return 1;
+    }
+
+    if (parser.isSet(asyncOption))
+        logger()->enableAsyncLogging();
+
+    QVector<Result> results;
+    for (const Api api : apis) {
+        for (const Output output : outputs) {
+            for (const bool filtered : { false, true }) {
+                for (const int size : sizes) {
+                    for (const int threads : threadCounts) {
+                        if (threads <= 0)
+                            continue;
+
+                        Scenario scenario;
+                        scenario.threads = threads;
+                        scenario.messageSize = size;
+                        scenario.filtered = filtered;
+                        scenario.output = output;
+                        scenario.api = api;
+                        results.append(run(scenario, messages, directory.path()));
+                    }
+                }
+            }
+        }
+    }
+
+    QFile result;
+    bool opened = false;
+    if (parser.isSet(resultOption)) {
+        result.setFileName(parser.value(resultOption));
+        opened = result.open(QFile::WriteOnly | QFile::Truncate);
+    } else {
+        opened = result.open(stdout, QFile::WriteOnly);
+    }
+    if (!opened) {
+        fprintf(stderr, "Could not open output: %s\n", qPrintable(result.errorString()));
+        return 1;
+    }
+
+    result.write(json ? toJson(results) : toCsv(results));
+    return 0;
+}
@@ -1,5 +1,5 @@
 QT = core
-CONFIG += c++11
+CONFIG += c++17
 
 # Just add this line to your project to include MiloLog!
 include(../mlog.pri)
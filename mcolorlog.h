@@ -1,6 +1,19 @@
 #pragma once
 
 #include <QDebug>
+#include <QLoggingCategory>
+
+/*!
+ * Most verbose MLog::LogLevel compiled into mDebug(), mInfo(), mCDebug() etc.
+ * (0 = MLog::NoLog ... 5 = MLog::DebugLog, default). Macros above this level
+ * expand to dead code: their arguments are never evaluated and the compiler
+ * removes them completely.
+ *
+ * Set it with DEFINES (qmake) or MLOG_COMPILED_LOG_LEVEL CMake option.
+ */
+#ifndef MLOG_COMPILED_LOG_LEVEL
+#define MLOG_COMPILED_LOG_LEVEL 5
+#endif
 
 #define redLogColor "\033[1;31m"
 #define greenLogColor "\033[1;32m"
@@ -52,12 +65,50 @@ private:
 };
 
 
-#define mCDebug(color, category, ...) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, category().categoryName()).debug(__VA_ARGS__))
-#define mCInfo(color, category, ...) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, category().categoryName()).info(__VA_ARGS__))
-#define mCWarning(color, category, ...) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, category().categoryName()).warning(__VA_ARGS__))
-#define mCCritical(color, category, ...) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, category().categoryName()).critical(__VA_ARGS__))
+//! Statement which is compiled out, together with everything streamed into it
+#define MLOG_NO_STREAM while (false) QMessageLogger().noDebug()
+
+//! Checks whether \a category is enabled (which includes MLog's global and
+//! per-category log levels) before QMessageLogger and QDebug are even
+//! constructed
+#define MLOG_COLOR_STREAM(type, function, color, category, ...) \
+    for (bool mlogEnabled = category().isEnabled(type); mlogEnabled; mlogEnabled = false) \
+        MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, \
+                                        category().categoryName()).function(__VA_ARGS__))
+
+#define MLOG_DEFAULT_COLOR_STREAM(type, function, color) \
+    for (bool mlogEnabled = QLoggingCategory::defaultCategory()->isEnabled(type); \
+         mlogEnabled; mlogEnabled = false) \
+        MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC).function())
+
+#if MLOG_COMPILED_LOG_LEVEL >= 5
+#define mCDebug(color, category, ...) MLOG_COLOR_STREAM(QtDebugMsg, debug, color, category, __VA_ARGS__)
+#define mDebug(color) MLOG_DEFAULT_COLOR_STREAM(QtDebugMsg, debug, color)
+#else
+#define mCDebug(color, category, ...) MLOG_NO_STREAM
+#define mDebug(color) MLOG_NO_STREAM
+#endif
+
+#if MLOG_COMPILED_LOG_LEVEL >= 4
+#define mCInfo(color, category, ...) MLOG_COLOR_STREAM(QtInfoMsg, info, color, category, __VA_ARGS__)
+#define mInfo(color) MLOG_DEFAULT_COLOR_STREAM(QtInfoMsg, info, color)
+#else
+#define mCInfo(color, category, ...) MLOG_NO_STREAM
+#define mInfo(color) MLOG_NO_STREAM
+#endif
+
+#if MLOG_COMPILED_LOG_LEVEL >= 3
+#define mCWarning(color, category, ...) MLOG_COLOR_STREAM(QtWarningMsg, warning, color, category, __VA_ARGS__)
+#define mWarning(color) MLOG_DEFAULT_COLOR_STREAM(QtWarningMsg, warning, color)
+#else
+#define mCWarning(color, category, ...) MLOG_NO_STREAM
+#define mWarning(color) MLOG_NO_STREAM
+#endif
 
-#define mDebug(color) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC).debug())
-#define mInfo(color) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC).info())
-#define mWarning(color) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC).warning())
-#define mCritical(color) MColorLog(color, QMessageLogger(QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC).critical())
+#if MLOG_COMPILED_LOG_LEVEL >= 2
+#define mCCritical(color, category, ...) MLOG_COLOR_STREAM(QtCriticalMsg, critical, color, category, __VA_ARGS__)
+#define mCritical(color) MLOG_DEFAULT_COLOR_STREAM(QtCriticalMsg, critical, color)
+#else
+#define mCCritical(color, category, ...) MLOG_NO_STREAM
+#define mCritical(color) MLOG_NO_STREAM
+#endif
@@ -0,0 +1,125 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+
+#include <cstdio>
+
+#include "mlogbinary.h"
+#include "mlogformatter.h"
+#include "mlogutf8.h"
+
+//! Turns binary MLog files (see MLog::FileFormat::Binary) back into text
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("mlog-decode"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                QStringLiteral("Converts binary MLog log file into text."));
+    parser.addHelpOption();
+    const QCommandLineOption patternOption(
+                { QStringLiteral("p"), QStringLiteral("pattern") },
+                QStringLiteral("Message pattern to use instead of the one stored "
+                               "in the file."),
+                QStringLiteral("pattern"));
+    const QCommandLineOption outputOption(
+                { QStringLiteral("o"), QStringLiteral("output") },
+                QStringLiteral("Write text to <file> instead of standard output."),
+                QStringLiteral("file"));
+    parser.addOption(patternOption);
+    parser.addOption(outputOption);
+    parser.addPositionalArgument(QStringLiteral("log"),
+                                 QStringLiteral("Binary log file to decode."));
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1)
+        parser.showHelp(1);
+
+    QFile input(arguments.first());
+    if (!input.open(QFile::ReadOnly)) {
+        fprintf(stderr, "Could not open %s: %s\n", qPrintable(input.fileName()),
+                qPrintable(input.errorString()));
+        return 1;
+    }
+
+    QFile output;
+    bool opened = false;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QFile::WriteOnly | QFile::Truncate);
+    } else {
+        opened = output.open(stdout, QFile::WriteOnly);
+    }
+    if (!opened) {
+        fprintf(stderr, "Could not open output: %s\n",
+                qPrintable(output.errorString()));
+        return 1;
+    }
+
+    MLogBinaryReader reader(&input);
+    if (!reader.readHeader()) {
+        fprintf(stderr, "%s: %s\n", qPrintable(input.fileName()),
+                qPrintable(reader.errorString()));
+        return 1;
+    }
+
+    MLogFormatter formatter(parser.isSet(patternOption)
+                            ? parser.value(patternOption) : reader.pattern());
+    formatter.setApplication(reader.appName(), reader.pid());
+
+    QByteArray text;
+    text.reserve(64 * 1024 + 4096);
+    MLogMessage message;
+    for (;;) {
+        const MLogBinaryReader::Result result = reader.next(message);
+        if (result == MLogBinaryReader::Result::End)
+            break;
+
+        if (result == MLogBinaryReader::Result::Error) {
+            output.write(text);
+            fprintf(stderr, "%s: %s\n", qPrintable(input.fileName()),
+                    qPrintable(reader.errorString()));
+            return 2;
+        }
+
+        if (result == MLogBinaryReader::Result::Raw) {
+            mlog::appendUtf8(text, message.message);
+        } else {
+            formatter.format(text, message);
+            text.append('\n');
+        }
+
+        if (text.size() >= 64 * 1024) {
+            output.write(text);
+            text.resize(0);
+        }
+    }
+
+    output.write(text);
+    return 0;
+}
@@ -0,0 +1,12 @@
+QT = core
+CONFIG += c++17
+
+include(../mlog.pri)
+
+TARGET = mlog-decode
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += main.cpp
@@ -22,22 +22,46 @@ SOFTWARE.
 *******************************************************************************/
 
 #include "mlog.h"
+#include "mlogmessage.h"
+#include "mlogwriter.h"
+#include "mlogutf8.h"
+#include "mlogformatter.h"
+#include "mlogclock.h"
+#include "mlogcallsite.h"
+#include "mlogbinary.h"
+#include "mlogworker.h"
+#include "mlogrotation.h"
+#include "mlogcategorylevels.h"
+#include "mlogconfig.h"
+#include "mlogjson.h"
+#include "mlogsink.h"
+#include "mlogstorage.h"
+#include "mlogflightrecorder.h"
+#include "mlogstatistics.h"
+#include "mlogstaging.h"
 
 #include <QString>
-#include <QTextStream>
 #include <QStandardPaths>
 #include <QCoreApplication>
 #include <QFileInfo>
 #include <QDir>
-#include <QRegularExpression>
 #include <QDateTime>
+#include <QThread>
+#include <QVarLengthArray>
 
-#ifdef ANDROID
-#include <android/log.h>
-#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 Q_LOGGING_CATEGORY(coreLogger, "core.logger")
 
+std::atomic<MLog::LogLevel> MLog::sLogLevel{MLog::DebugLog};
+
+//! Size above which the file buffer is always written out
+static const int fileBufferSize = 64 * 1024;
+//! Time (ms) between attempts to delete replaced configuration snapshots
+static const int configReclaimInterval = 50;
+
 /*!
  * \class MLog
  * \brief Simple logger with capability to log into file
@@ -76,19 +100,63 @@ Q_LOGGING_CATEGORY(coreLogger, "core.logger")
  \endcode
  */
 MLog::MLog()
+    : m_configReaders(new MLogConfigReaders), m_worker(new MLogWorker),
+      m_console(new MLogConsoleSink), m_statistics(new MLogStatisticsCounters),
+      m_lastMessage(new MLogMessage), m_callSites(new MLogCallSites),
+      m_staging(new MLogStaging)
 {
+    m_config.store(new MLogConfig);
+    m_console->m_scheduleFlush = [this](const int delay) {
+        m_worker->postDelayed([this]() { m_console->flush(); }, delay);
+    };
+
     // use backslashes between '%' and '{' to avoid shadowing this placeholders with
     // similar placeholders from wizard.json file during the Qt Creator wizard creation
-    qSetMessagePattern("%\{time}|%\{type}%\{if-category}|%\{category}%\{endif}|%\{function}: "
-                       "%\{message}");
+    setMessagePattern("%\{time}|%\{type}%\{if-category}|%\{category}%\{endif}|%\{function}: "
+                      "%\{message}");
     qInstallMessageHandler(&messageHandler);
+    MLogCategoryLevels::install();
+
+    // Reserve once, so that the buffer keeps its capacity when it is emptied
+    m_fileBuffer.reserve(fileBufferSize + 4096);
 }
 
 /*!
- * Just a destructor. Does not do anything interesting.
+ * Uninstalls the message handler and, if asynchronous logging was enabled,
+ * writes out all pending messages before stopping the writer thread.
  */
 MLog::~MLog()
 {
+    qInstallMessageHandler(nullptr);
+    if (config()->profiling)
+        writeCallSiteReport(config()->profilingReportSize);
+    MLogCategoryLevels::uninstall();
+    MLogFlightRecorder::uninstallCrashHandler();
+    MLogFlightRecorder::setCrashRecorder(nullptr);
+    if (MLogWriter *writer = m_writer.load(std::memory_order_acquire)) {
+        changeConfig([](MLogConfig &config) { config.asyncLogging = false; });
+        writer->stop();
+        m_writer.store(nullptr, std::memory_order_release);
+        delete writer;
+    }
+
+    // Finishes pending rotation and scheduled flushes
+    delete m_worker;
+    m_console->flush();
+    {
+        QMutexLocker locker(&m_mutex);
+        closeLogFile();
+    }
+
+    qDeleteAll(m_config.load()->sinks);
+    delete m_config.load()->flightRecorder;
+    delete m_console;
+    delete m_config.load();
+    delete m_configReaders;
+    delete m_callSites;
+    delete m_lastMessage;
+    delete m_statistics;
+    delete m_staging;
 }
 
 /*!
@@ -119,6 +187,9 @@ MLog *MLog::instance()
  * running, use disableLogToFile().
  *
  * If you do not have logs \a directory it will be created.
+ *
+ * By default old logs are rotated before this function returns. See
+ * setBackgroundRotation() to move that work off application startup.
  */
 void MLog::enableLogToFile(const QString &appName, const QString &directory)
 {
@@ -135,47 +206,471 @@ void MLog::enableLogToFile(const QString &appName, const QString &directory)
         }
     }
 
-    m_previousLogPath = findPreviousLogPath(directory, appName);
-    if (m_rotationType == MLog::RotationType::Consequent) {
-        m_currentLogPath = directory + '/' + appName + "-current" + m_fileExt;
+    // Log file is enabled again, close the old one before it is rotated
+    if (config()->logToFile)
+        disableLogToFile();
+
+    RotationType rotationType;
+    int maxLogs;
+    bool background;
+    {
+        QMutexLocker locker(&m_mutex);
+        rotationType = m_rotationType;
+        maxLogs = m_maxLogs;
+        background = m_backgroundRotation;
     }
-    else if (m_rotationType == MLog::RotationType::DateTime) {
-        const auto currentDate = QDateTime::currentDateTime().toString(m_dateTimeFormat);
-        m_currentLogPath = directory + '/' + appName + "-" + currentDate + m_fileExt;
+
+    const MLogRotation rotation(directory, appName, rotationType, maxLogs);
+    const QString currentLogPath = rotation.currentLogPath(
+                QDateTime::currentMSecsSinceEpoch());
+    QString previousLogPath;
+    QString closedLogPath;
+    if (background) {
+        // Only move the old log out of the way, the rest is done by the worker
+        // once the new log is open (and after any rotation still pending)
+        if (rotationType == MLog::RotationType::Consequent
+                && QFileInfo::exists(currentLogPath)) {
+            quint64 count = 0;
+            {
+                QMutexLocker locker(&m_mutex);
+                count = ++m_rotationCount;
+            }
+            closedLogPath = rotation.rotatedLogPath(
+                        QDateTime::currentMSecsSinceEpoch(), count);
+            // Old log can not be moved, it has to be rotated right now
+            if (QFile::rename(currentLogPath, closedLogPath) == false)
+                background = false;
+        }
+        previousLogPath = rotation.previousLogPath();
     }
 
-    rotateLogFiles(appName);
+    if (background == false) {
+        // Rotation started while logging to the previous file must be done
+        // first, compression in progress gives way
+        m_worker->execute([&]() {
+            previousLogPath = rotation.startup(currentLogPath, currentLogPath);
+        });
+    }
 
     // Open appName-current.log and write init message
-    m_logFile.setFileName(m_currentLogPath);
-    if (!m_logFile.open(QFile::WriteOnly | QFile::Text)) {
+    bool opened = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_appName = appName;
+        m_logDirectory = directory;
+        m_previousLogPath = previousLogPath;
+        m_currentLogPath = currentLogPath;
+        opened = openLogFile(config()->fileFormat, false);
+    }
+
+    if (background) {
+        m_worker->post([this, rotation, currentLogPath, closedLogPath]() {
+            const QString previousLogPath = rotation.startup(currentLogPath,
+                                                             closedLogPath);
+            QMutexLocker locker(&m_mutex);
+            // Unless the log was rotated again in the meantime
+            if (m_currentLogPath == currentLogPath)
+                m_previousLogPath = previousLogPath;
+        });
+    }
+    scheduleCompression(rotation);
+
+    if (!opened) {
         qCCritical(coreLogger) << "Could not open log file for writing!";
         QCoreApplication::instance()->exit(2);
         return;
     } else {
-      m_logToFile = true;
+      changeConfig([](MLogConfig &config) { config.logToFile = true; });
     }
 }
 
 /*!
  * Disables writing logs into a file. Log messages will continue to be printed
  * into the console (cerr).
+ *
+ * In asynchronous mode, all messages logged before this call are written to
+ * the file before it is closed.
  */
 void MLog::disableLogToFile()
 {
-    m_logFile.close();
-    m_logToFile = false;
+    flush();
+    changeConfig([](MLogConfig &config) { config.logToFile = false; });
+    QMutexLocker locker(&m_mutex);
+    closeLogFile();
 }
 
 /*!
  * Sets log rotation to \a type.
  * \a maxLogs determines how many logs can be in directory
  * in format <appName>-<order_identifier>.log
+ *
+ * By default logs are only rotated by enableLogToFile(). If \a maxFileSize
+ * (in bytes) is greater than 0, current log is also rotated whenever the
+ * next message would make it bigger than that. If \a maxFileAge (in seconds)
+ * is greater than 0, current log is rotated once it is that old.
+ *
+ * Runtime rotation only closes current log, moves it out of the way and
+ * opens a new one - messages are never split between files. Renaming older
+ * logs and removing the ones above \a maxLogs is done by a background
+ * thread.
+ *
+ * Should be called before enableLogToFile().
  */
-void MLog::setLogRotation(MLog::RotationType type, int maxLogs)
+void MLog::setLogRotation(MLog::RotationType type, int maxLogs,
+                          const qint64 maxFileSize, const int maxFileAge)
 {
+    QMutexLocker locker(&m_mutex);
     m_rotationType = type;
     m_maxLogs = maxLogs;
+    m_maxFileSize = maxFileSize;
+    m_maxFileAge = maxFileAge;
+}
+
+/*!
+ * If \a enabled is true, enableLogToFile() does not wait for log rotation.
+ * It only moves the old log file out of the way and opens the new one, so
+ * the application can start logging right away. Rotating older logs and
+ * removing the ones above the limit is done by a background thread.
+ *
+ * With MLog::RotationType::DateTime, previousLogPath() is only known once
+ * background rotation is done, it returns an empty string until then.
+ *
+ * Disabled by default.
+ */
+void MLog::setBackgroundRotation(const bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_backgroundRotation = enabled;
+}
+
+/*!
+ * Returns true if enableLogToFile() rotates logs in the background.
+ *
+ * \sa setBackgroundRotation
+ */
+bool MLog::isBackgroundRotation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_backgroundRotation;
+}
+
+/*!
+ * Enables compression of log files which are no longer current. Logs are
+ * compressed with gzip (zlib compression \a level, 0-9) by MLog's
+ * maintenance thread, after they are rotated, and get ".gz" appended to
+ * their names. previousLogPath() follows the rename.
+ *
+ * The maintenance thread, which also rotates logs and runs scheduled file
+ * and console flushes, is lowered to \a priority only while it compresses.
+ * Compression never holds up writing into the current log, and gives way
+ * whenever the maintenance thread has anything else to do.
+ *
+ * \sa disableLogCompression
+ */
+void MLog::enableLogCompression(const int level, const QThread::Priority priority)
+{
+    m_compressionLevel.store(qBound(0, level, 9));
+    m_logCompression.store(true);
+    m_compressionPriority.store(priority);
+
+    QMutexLocker locker(&m_mutex);
+    if (m_appName.isEmpty() == false) {
+        // Compress logs left over from previous runs
+        scheduleCompression(MLogRotation(m_logDirectory, m_appName,
+                                         m_rotationType, m_maxLogs));
+    }
+}
+
+/*!
+ * Disables compression of log files. Logs which are already compressed are
+ * kept compressed.
+ *
+ * \sa enableLogCompression
+ */
+void MLog::disableLogCompression()
+{
+    m_logCompression.store(false);
+}
+
+/*!
+ * Returns true if rotated logs are compressed.
+ *
+ * \sa enableLogCompression
+ */
+bool MLog::isLogCompression() const
+{
+    return m_logCompression.load();
+}
+
+/*!
+ * Sets format of the log file to \a format. Takes effect the next time
+ * enableLogToFile() is called. Console output is always text.
+ *
+ * MLog::FileFormat::Binary defers all formatting: the file contains only raw
+ * message data (call site, timestamp, thread and message text), each call
+ * site (file, line, function and category) is stored only once per file.
+ * This makes logging considerably cheaper. Binary logs are turned into text
+ * by the mlog-decode tool, using the message pattern stored in the file:
+ * \code
+ * mlog-decode MyApp-current.log > MyApp.txt
+ * \endcode
+ *
+ * MLog::FileFormat::Json writes one JSON object per line, for log analytics
+ * tools. Each object holds time (milliseconds since epoch), level, category,
+ * thread, file, line, function and message, plus a "fields" object for
+ * messages logged with mRecord() and mCRecord() (see MLogRecord). Records
+ * are encoded straight into MLog's output buffer. The message pattern does
+ * not apply to JSON files.
+ *
+ * Binary and JSON log files use the same names (and rotation) as text ones.
+ */
+void MLog::setFileFormat(const FileFormat format)
+{
+    changeConfig([format](MLogConfig &config) { config.fileFormat = format; });
+}
+
+/*!
+ * Returns format used for log files opened from now on. Default is
+ * MLog::FileFormat::Text.
+ *
+ * \sa setFileFormat
+ */
+MLog::FileFormat MLog::fileFormat() const
+{
+    return config()->fileFormat;
+}
+
+/*!
+ * Sets \a policy deciding when messages collected in MLog's file buffer are
+ * written into the log file. Messages which are not written out yet are lost
+ * if the application crashes; writing less often is cheaper.
+ *
+ * \li FileFlushPolicy::Default - every message is written right away, in
+ * asynchronous mode whenever the writer thread runs out of messages
+ * \li FileFlushPolicy::Buffered - only when 64 KiB are pending
+ * \li FileFlushPolicy::Periodic - at most \a interval milliseconds after the
+ * message was logged, or once \a size bytes are pending (if greater than 0)
+ *
+ * Whatever the policy, the buffer is written out by flush(), before qFatal()
+ * aborts the application, on rotation and when the log file is closed. Data
+ * written into the file survives a crash of the application; to survive a
+ * crash of the system, see setSyncOnCritical().
+ *
+ * \code
+ * logger()->setFileFlushPolicy(MLog::FileFlushPolicy::Periodic, 500);
+ * \endcode
+ */
+void MLog::setFileFlushPolicy(const FileFlushPolicy policy, const int interval,
+                              const qint64 size)
+{
+    QMutexLocker locker(&m_mutex);
+    flushFileBuffer();
+    m_fileFlushPolicy = policy;
+    m_fileFlushInterval = interval;
+    m_fileFlushSize = qMin(size, qint64(fileBufferSize));
+}
+
+/*!
+ * Returns log file flush policy.
+ *
+ * \sa setFileFlushPolicy
+ */
+MLog::FileFlushPolicy MLog::fileFlushPolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fileFlushPolicy;
+}
+
+/*!
+ * If \a enabled, log file is synchronized to disk (fdatasync() on Linux,
+ * FlushFileBuffers() on Windows) after every qCritical() and qFatal()
+ * message, together with everything logged before it. This way the messages
+ * most likely to explain a crash survive even a crash of the whole system.
+ *
+ * Synchronizing is slow (often several milliseconds), it is disabled by
+ * default.
+ */
+void MLog::setSyncOnCritical(const bool enabled)
+{
+    m_syncOnCritical.store(enabled, std::memory_order_relaxed);
+}
+
+/*!
+ * Returns true if log file is synchronized after critical messages.
+ *
+ * \sa setSyncOnCritical
+ */
+bool MLog::isSyncOnCritical() const
+{
+    return m_syncOnCritical.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Preallocates disk space for the log file in chunks of \a chunkSize bytes
+ * (0, the default, disables it). Writes into preallocated space do not have
+ * to update file system metadata, which makes them cheaper and less likely
+ * to fragment the file. The file is truncated to its real size when it is
+ * closed or rotated.
+ *
+ * Only supported on Linux (fallocate()), ignored elsewhere.
+ *
+ * \code
+ * logger()->setFilePreallocation(4 * 1024 * 1024);
+ * \endcode
+ */
+void MLog::setFilePreallocation(const qint64 chunkSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_preallocationChunk = qMax(chunkSize, qint64(0));
+}
+
+/*!
+ * Returns size of log file preallocation chunks, or 0 if it is disabled.
+ *
+ * \sa setFilePreallocation
+ */
+qint64 MLog::filePreallocation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_preallocationChunk;
+}
+
+/*!
+ * Sets message \a pattern, used for both log file and console output. Syntax
+ * is the same as in qSetMessagePattern() (which is also called, so Qt and
+ * MLog stay in sync).
+ *
+ * MLog parses the pattern once and renders messages directly into its output
+ * buffer, without going through qFormatLogMessage(). Output is identical to
+ * what qFormatLogMessage() produces. Patterns using %{backtrace},
+ * %{time process} or %{time boot} are handed over to qFormatLogMessage().
+ *
+ * Just like in Qt, QT_MESSAGE_PATTERN environment variable takes precedence
+ * over \a pattern.
+ *
+ * Default pattern is:
+ * \code
+ * %{time}|%{type}%{if-category}|%{category}%{endif}|%{function}: %{message}
+ * \endcode
+ */
+void MLog::setMessagePattern(const QString &pattern)
+{
+    qSetMessagePattern(pattern);
+
+    const QString environmentPattern(qEnvironmentVariable("QT_MESSAGE_PATTERN"));
+    // Other threads might be formatting with the old formatter right now,
+    // shared formatters are never deleted
+    m_formatter.store(MLogFormatter::shared(environmentPattern.isEmpty()
+                                            ? pattern : environmentPattern),
+                      std::memory_order_release);
+}
+
+/*!
+ * Returns message pattern currently in use.
+ *
+ * \sa setMessagePattern
+ */
+QString MLog::messagePattern() const
+{
+    return m_formatter.load()->pattern();
+}
+
+/*!
+ * Sets the clock used to timestamp messages to \a source and timestamp
+ * precision to \a precision.
+ *
+ * MLog::ClockSource::Coarse and MLog::ClockSource::Monotonic are cheaper to
+ * read than the default MLog::ClockSource::System, at the cost of a few
+ * milliseconds of resolution (Coarse) or not following wall clock adjustments
+ * (Monotonic).
+ *
+ * With MLog::TimestampPrecision::Seconds timestamps are truncated to whole
+ * seconds, so all messages logged within the same second render their
+ * %{time} field from cache.
+ */
+void MLog::setClockSource(const ClockSource source,
+                          const TimestampPrecision precision)
+{
+    changeConfig([source, precision](MLogConfig &config) {
+        config.clockSource = source;
+        config.timestampPrecision = precision;
+    });
+}
+
+/*!
+ * Returns clock used to timestamp messages. Default is
+ * MLog::ClockSource::System.
+ *
+ * \sa setClockSource
+ */
+MLog::ClockSource MLog::clockSource() const
+{
+    return config()->clockSource;
+}
+
+/*!
+ * Returns precision of message timestamps. Default is
+ * MLog::TimestampPrecision::Milliseconds.
+ *
+ * \sa setClockSource
+ */
+MLog::TimestampPrecision MLog::timestampPrecision() const
+{
+    return config()->timestampPrecision;
+}
+
+/*!
+ * Attaches \a sink: from now on all messages (which pass the sink's own log
+ * level) are written into it, in addition to the log file and the console.
+ * MLog takes ownership of \a sink.
+ *
+ * Each sink can have its own message pattern. Messages are formatted once
+ * per distinct pattern, no matter how many sinks use it, so sinks sharing a
+ * pattern (or using MLog's default one) cost only the write itself.
+ *
+ * \code
+ * MLogMemorySink *recent = new MLogMemorySink(200);
+ * recent->setLogLevel(MLog::WarningLog);
+ * logger()->addSink(recent);
+ * \endcode
+ *
+ * \sa removeSink, MLogSink
+ */
+void MLog::addSink(MLogSink *sink)
+{
+    if (sink == nullptr)
+        return;
+
+    changeConfig([sink](MLogConfig &config) {
+        if (config.sinks.contains(sink) == false)
+            config.sinks.append(sink);
+    });
+}
+
+/*!
+ * Detaches and deletes \a sink, no more messages are written into it. Other
+ * threads might still be writing into the sink while this function returns,
+ * so it is deleted later, on MLog's worker thread, once none of them uses it
+ * anymore. \a sink must not be used after this call.
+ *
+ * \sa addSink
+ */
+void MLog::removeSink(MLogSink *sink)
+{
+    changeConfig([this, sink](MLogConfig &config) {
+        if (config.sinks.removeAll(sink) > 0)
+            m_configReaders->retire([sink]() { delete sink; });
+    });
+}
+
+/*!
+ * Returns attached sinks.
+ *
+ * \sa addSink
+ */
+QVector<MLogSink *> MLog::sinks() const
+{
+    return config()->sinks;
 }
 
 /*!
@@ -184,7 +679,7 @@ void MLog::setLogRotation(MLog::RotationType type, int maxLogs)
  */
 void MLog::enableLogToConsole()
 {
-    m_logToConsole = true;
+    changeConfig([](MLogConfig &config) { config.logToConsole = true; });
 }
 
 /*!
@@ -193,7 +688,45 @@ void MLog::enableLogToConsole()
  */
 void MLog::disableLogToConsole()
 {
-    m_logToConsole = false;
+    changeConfig([](MLogConfig &config) { config.logToConsole = false; });
+    m_console->flush();
+}
+
+/*!
+ * Sets console flush \a policy. By default (ConsoleFlushPolicy::Immediate)
+ * every message is written to stderr, and flushed, right away. With other
+ * policies messages are collected in a buffer and written out in bigger
+ * chunks, which is much cheaper when a lot is logged:
+ *
+ * \li ConsoleFlushPolicy::LineCount - once \a threshold lines are pending
+ * \li ConsoleFlushPolicy::Interval - at most \a threshold milliseconds after
+ * the message was logged
+ * \li ConsoleFlushPolicy::Severity - qWarning() and more severe messages are
+ * written right away, together with everything logged before them
+ *
+ * Buffered messages never wait longer than a second (or \a threshold for
+ * ConsoleFlushPolicy::Interval); they are also written out by flush(), before
+ * qFatal() aborts the application and when MLog is destroyed.
+ *
+ * On Android messages always go to logcat right away.
+ *
+ * \code
+ * logger()->setConsoleFlushPolicy(MLog::ConsoleFlushPolicy::Interval, 200);
+ * \endcode
+ */
+void MLog::setConsoleFlushPolicy(const ConsoleFlushPolicy policy, const int threshold)
+{
+    m_console->setFlushPolicy(policy, threshold);
+}
+
+/*!
+ * Returns console flush policy.
+ *
+ * \sa setConsoleFlushPolicy
+ */
+MLog::ConsoleFlushPolicy MLog::consoleFlushPolicy() const
+{
+    return m_console->flushPolicy();
 }
 
 /*!
@@ -205,6 +738,7 @@ void MLog::disableLogToConsole()
  */
 QString MLog::previousLogPath() const
 {
+    QMutexLocker locker(&m_mutex);
     return m_previousLogPath;
 }
 
@@ -217,6 +751,7 @@ QString MLog::previousLogPath() const
  */
 QString MLog::currentLogPath() const
 {
+    QMutexLocker locker(&m_mutex);
     return m_currentLogPath;
 }
 
@@ -227,10 +762,17 @@ QString MLog::currentLogPath() const
  * For example, if \a level is set to MLog::WarningLog, MLog will not print
  * messages declared using qDebug() and qInfo(), but it will print qWarning(),
  * qCritical() and qFatal() messages.
+ *
+ * \a level applies to all categories which do not have their own level set
+ * with setCategoryLogLevels(). It is applied through Qt's category filter,
+ * so qCDebug(), mDebug(), mCInfo() and friends check it before anything is
+ * streamed, and disabled messages cost a single atomic load. Levels can
+ * also be removed at compile time, see MLOG_COMPILED_LOG_LEVEL.
  */
 void MLog::setLogLevel(const MLog::LogLevel level)
 {
-    m_logLevel = level;
+    sLogLevel.store(level, std::memory_order_relaxed);
+    MLogCategoryLevels::update();
 }
 
 /*!
@@ -240,241 +782,1671 @@ void MLog::setLogLevel(const MLog::LogLevel level)
  */
 MLog::LogLevel MLog::logLevel() const
 {
-    return m_logLevel;
-}
-
-/*!
-    * Writes log \a message exactly as given - without any processing and
-    * without adding log category string.
-    *
-    * \warning Newline character is not appended to the \a message!
-*/
-void MLog::writeRaw(QtMsgType type, const QString &message)
-{
-    if (m_logToFile)
-        logger()->write(message);
-
-    if (logger()->isMessageAllowed(type)) {
-        fprintf(stderr, "%s", qPrintable(message));
-        fflush(stderr);
-    }
+    return sLogLevel.load(std::memory_order_relaxed);
 }
 
 /*!
- * Standard Qt messageHandler. MLog only adds the option to write to file
- * (use enableLogToFile() to, well, enable writing logs to a file) and log level
- * controls (see setLogLevel() and isMessageAllowed() for more details).
+ * Sets log levels of logging categories according to \a rules, replacing
+ * rules set earlier. Each rule has the form \c{<category>=<level>}, rules
+ * are separated by commas, semicolons or new lines:
+ * \code
+ * logger()->setLogLevel(MLog::WarningLog);
+ * logger()->setCategoryLogLevels("net.*=debug, db=warning");
+ * \endcode
  *
- * \a type, \a context, \a message have exactly the same meaning as in Qt's
- * built-in message handler and behave the same.
+ * Category may start and/or end with '*', just like in
+ * QLoggingCategory::setFilterRules(). Level is one of: none (or off), fatal,
+ * critical, warning, info, debug. When more than one rule matches a category,
+ * the last one wins. Categories without a matching rule use logLevel().
  *
- * MLog respects categorized logging settings (qCDebug() and friends).
+ * Levels are applied by Qt's category filter, which MLog chains after the
+ * one installed before it: QT_LOGGING_RULES and
+ * QLoggingCategory::setFilterRules() are still respected, a message has to be
+ * enabled by both. Each category's threshold is computed once, when it is
+ * created or when levels change - deciding whether to log is a single atomic
+ * load and disabled qCDebug() and mCDebug() never build their QDebug stream.
  *
- * \sa enableLogToFile, setLogLevel, isMessageAllowed
+ * Returns false if some of the \a rules could not be parsed, the remaining
+ * ones are applied anyway.
+ *
+ * \sa setCategoryLogLevel, clearCategoryLogLevels
  */
-void MLog::messageHandler(QtMsgType type, const QMessageLogContext &context,
-                          const QString &message)
+bool MLog::setCategoryLogLevels(const QString &rules)
 {
-    MLog *log = logger();
-    if (log->isMessageAllowed(type) == false)
-        return;
-
-    const QString formatted(qFormatLogMessage(type, context, message));
-    if (log->m_logToFile)
-      log->write(formatted + "\n");
-
-    if (log->m_logToConsole == false)
-      return;
-
-#ifdef ANDROID
-    android_LogPriority priority = ANDROID_LOG_DEBUG;
-    switch (type) {
-        case QtWarningMsg: priority = ANDROID_LOG_WARN; break;
-        case QtCriticalMsg: priority = ANDROID_LOG_ERROR; break;
-        case QtFatalMsg: priority = ANDROID_LOG_FATAL; break;
-        case QtInfoMsg: priority = ANDROID_LOG_INFO; break;
-        default: priority = ANDROID_LOG_DEBUG; break;
-    };
-    __android_log_print(priority, "Qt", "%s", qPrintable(formatted));
-#else
-    fprintf(stderr, "%s\n", qPrintable(formatted));
-    fflush(stderr);
-#endif
+    QVector<MLogCategoryLevels::Rule> parsed;
+    const bool ok = MLogCategoryLevels::parse(rules, parsed);
+    MLogCategoryLevels::setRules(parsed);
+    return ok;
 }
 
 /*!
- * Writes \a message into current log file.
+ * Sets log level of \a category (which may contain wildcards, see
+ * setCategoryLogLevels()) to \a level. The rule is added after existing ones,
+ * so it takes precedence over them.
  *
- * This function first checks whether log file is open and writable.
+ * \sa setCategoryLogLevels
  */
-void MLog::write(const QString &message)
+void MLog::setCategoryLogLevel(const QString &category, const LogLevel level)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_logFile.isOpen() && m_logFile.isWritable()) {
-        QTextStream logStream(&m_logFile);
-
-#if QT_VERSION >= 0x060000
-        logStream.setEncoding(QStringConverter::Utf8);
-#else
-        logStream.setCodec("UTF-8");
-#endif
-
-        logStream << message;
-    }
+    MLogCategoryLevels::addRule(MLogCategoryLevels::rule(category, level));
 }
 
 /*!
- * Returns true if log level \a qtLevel is within logger logging level set
- * in setLogLevel().
+ * Removes all per-category log levels, logLevel() applies to all categories
+ * again.
  *
- * \sa setLogLevel
+ * \sa setCategoryLogLevels
  */
-bool MLog::isMessageAllowed(const QtMsgType qtLevel) const
+void MLog::clearCategoryLogLevels()
 {
-    if (m_logLevel == NoLog)
-        return false;
-
-    switch (qtLevel) {
-    case QtDebugMsg:
-        return (m_logLevel >= DebugLog);
-    case QtInfoMsg:
-        return (m_logLevel >= InfoLog);
-    case QtWarningMsg:
-        return (m_logLevel >= WarningLog);
-    case QtCriticalMsg:
-        return (m_logLevel >= CriticalLog);
-    case QtFatalMsg:
-        return (m_logLevel >= FatalLog);
-    }
-
-    return false;
+    MLogCategoryLevels::setRules(QVector<MLogCategoryLevels::Rule>());
 }
 
 /*!
- * Returns the singleton instance of MLog. Synonym to MLog::instance(),
- * but easier to write.
+ * Returns log level which applies to \a category: either set by
+ * setCategoryLogLevels() or, if no rule matches, logLevel().
  */
-MLog *logger()
+MLog::LogLevel MLog::categoryLogLevel(const char *category) const
 {
-    return MLog::instance();
+    return MLogCategoryLevels::level(category);
 }
 
 /*!
- * Rotates logFiles beginning with \a appName.
+ * Samples messages of categories matching \a category (same patterns as in
+ * setCategoryLogLevels(), e.g. "net.*"): messages at \a level or more
+ * verbose are logged only 1 in \a oneIn times, chosen at random. Use "*" to
+ * sample a level in all categories. Later calls take precedence over earlier
+ * ones, \a oneIn of 1 or less logs all messages again.
  *
- * This function changes file names when MLog::RotationType is Consequent.
- * It also deletes oldest log file if maxLogs is exceeded.
+ * The decision is made before the message is formatted, with a per-thread
+ * random number generator, so rejected messages cost almost nothing. Logged
+ * messages get a "sampled" field with \a oneIn (see MLogRecord), so analysis
+ * tools can scale counts back up.
  *
- * \sa setLogRotation(RotationType type, int maxLogs)
+ * \code
+ * logger()->setSampling("net.packets", MLog::DebugLog, 100);
+ * \endcode
+ *
+ * \sa clearSampling
  */
-void MLog::rotateLogFiles(const QString &appName)
+void MLog::setSampling(const QString &category, const LogLevel level, const int oneIn)
 {
-    const QString logFilePath(QStandardPaths::writableLocation(
-                                  QStandardPaths::DocumentsLocation));
-    const QDir logsDir(logFilePath);
-    const QStringList logFilter(appName + "-*" + m_fileExt);
-    const auto files = logsDir.entryList(logFilter, QDir::Files, QDir::Reversed);
-
-    if (m_rotationType == MLog::RotationType::Consequent) {
-        const QRegularExpression expr("("+appName+"-previous-)([1-9][0-9]*)"
-                                      + m_fileExt);
-
-        // replace names for all previous files
-        for(const auto &file : qAsConst(files)) {
-            const auto match = expr.match(file);
-            if (match.hasMatch()) {
-                const auto prefix = match.captured(1);
-                int index = match.captured(2).toInt();
-                ++index;
-
-                QString newFilePath = prefix + QString::number(index) + m_fileExt;
-                const auto oldFilePath = logsDir.absoluteFilePath(file);
-                newFilePath = logsDir.absoluteFilePath(newFilePath);
-
-                QFile::rename(oldFilePath, newFilePath);
-            }
-        }
-
-        const QString newPrev = logFilePath + '/' + appName + "-previous-1" + m_fileExt;
-        QFile::rename(m_previousLogPath, newPrev);
-    }
-
-    if (files.size()+1 > m_maxLogs)
-        removeLastLog(appName, logsDir);
-
-    if (QFileInfo::exists(m_currentLogPath))
-        QFile::rename(m_currentLogPath, m_previousLogPath);
+    MLogCategoryLevels::Sampling sampling;
+    sampling.rule = MLogCategoryLevels::rule(category, level);
+    sampling.oneIn = qMax(oneIn, 1);
+    MLogCategoryLevels::addSampling(sampling);
+    changeConfig([](MLogConfig &config) { config.sampling = true; });
 }
 
 /*!
- * Finds previous log file path in \a logFileDir with \a appName.
+ * Removes all sampling rules, all messages are logged again.
+ *
+ * \sa setSampling
  */
-QString MLog::findPreviousLogPath(const QString &logFileDir, const QString &appName)
+void MLog::clearSampling()
 {
-    if (m_rotationType == MLog::RotationType::Consequent) {
-        return logFileDir + '/' + appName + "-previous" + m_fileExt;
-    } else if (m_rotationType == MLog::RotationType::DateTime) {
-        const QDir logsDir(logFileDir);
-        const QStringList logFilter(appName + "-*" + m_fileExt);
-        const auto files = logsDir.entryList(logFilter, QDir::Files, QDir::Reversed);
-        const QRegularExpression expr(
-            "(" + appName + "-)(\\d\\d\\d\\d-\\d\\d-\\d\\d_\\d\\d-\\d\\d-\\d\\d)"
-            + m_fileExt);
-
-        for(const auto &file : qAsConst(files)) {
-            const auto match = expr.match(file);
-            if (match.hasMatch())
-                return logFileDir + '/' + file;
+    changeConfig([](MLogConfig &config) { config.sampling = false; });
+    MLogCategoryLevels::clearSampling();
+}
+
+/*!
+    * Writes log \a message exactly as given - without any processing and
+    * without adding log category string.
+    *
+    * \warning Newline character is not appended to the \a message!
+*/
+void MLog::writeRaw(QtMsgType type, const QString &message)
+{
+    MLogMessage entry;
+    entry.type = type;
+    const MLogConfigRef config = this->config();
+    entry.timestamp = currentTimestamp(config.get());
+    entry.message = message;
+    entry.raw = true;
+    if (config->statistics)
+        m_statistics->addMessage(type);
+
+    if (config->asyncLogging) {
+        m_writer.load(std::memory_order_acquire)->enqueue(std::move(entry));
+        return;
+    }
+
+    output(entry);
+}
+
+/*!
+ * Logs UTF-8 encoded \a message of \a type, with \a context, just like
+ * messages received from Qt. Filters (levels, sampling, rate limits) apply
+ * exactly as for qCDebug() and friends, but Qt's message handling and QDebug
+ * are skipped. This is what the formatted logging functions (see mlog::info())
+ * use.
+ *
+ * Text stays in UTF-8 all the way to the log file and sinks, it is never
+ * converted to QString. In synchronous mode it is not even copied.
+ *
+ * Category of \a context is not checked against QLoggingCategory here, the
+ * caller should do it before composing the message.
+ */
+void MLog::logUtf8(QtMsgType type, const QMessageLogContext &context,
+                   const QByteArray &message)
+{
+    handleMessage(type, context, QString(), message);
+}
+
+/*!
+ * Limits how many messages are logged: every call site (or every category,
+ * depending on \a scope) can log at most \a messagesPerSecond messages per
+ * second on average, with bursts of up to \a burst messages (by default
+ * \a messagesPerSecond). Messages above the limit are dropped right in the
+ * message handler, before they are formatted, queued or written, so one
+ * runaway loop can not fill the disk or slow down other threads.
+ *
+ * The first message let through after some were dropped gets a
+ * "suppressed" field with their number (see MLogRecord). qFatal() messages
+ * are never limited.
+ *
+ * Limits are token buckets kept in a lock-free registry of call sites, the
+ * check costs a few atomic operations. Call sites are identified by
+ * QMessageLogContext, which only contains file, line and function when
+ * QT_MESSAGELOGCONTEXT is defined (or in debug builds). Otherwise all
+ * messages of a category share one limit.
+ *
+ * \code
+ * logger()->enableRateLimit(10, 100);
+ * \endcode
+ *
+ * \sa disableRateLimit, suppressedMessageCount, setCollapseRepeatedMessages
+ */
+void MLog::enableRateLimit(const int messagesPerSecond, const int burst,
+                           const RateLimitScope scope)
+{
+    if (messagesPerSecond <= 0) {
+        disableRateLimit();
+        return;
+    }
+
+    const qint64 interval = qMax(Q_INT64_C(1000000000) / messagesPerSecond, qint64(1));
+    const int bucketSize = burst > 0 ? burst : messagesPerSecond;
+    changeConfig([=](MLogConfig &config) {
+        config.rateLimitInterval = interval;
+        config.rateLimitTolerance = interval * (bucketSize - 1);
+        config.rateLimitScope = scope;
+    });
+}
+
+/*!
+ * Disables rate limit, all messages are logged again.
+ *
+ * \sa enableRateLimit
+ */
+void MLog::disableRateLimit()
+{
+    changeConfig([](MLogConfig &config) { config.rateLimitInterval = 0; });
+}
+
+/*!
+ * Returns true if rate limit is enabled.
+ *
+ * \sa enableRateLimit
+ */
+bool MLog::isRateLimit() const
+{
+    return config()->rateLimitInterval > 0;
+}
+
+/*!
+ * Returns number of messages dropped by the rate limit so far.
+ *
+ * \sa enableRateLimit
+ */
+quint64 MLog::suppressedMessageCount() const
+{
+    return m_suppressedCount.load(std::memory_order_relaxed);
+}
+
+/*!
+ * If \a enabled, consecutive identical messages (same type, category and
+ * text) are collapsed: only the first one is logged, followed by a single
+ * "Last message repeated N times" message once a different message is
+ * logged, or at most a second later. Messages with MLogRecord fields are
+ * never collapsed.
+ *
+ * Disabled by default.
+ *
+ * \sa enableRateLimit
+ */
+void MLog::setCollapseRepeatedMessages(const bool enabled)
+{
+    if (MLogWriter *writer = m_writer.load(std::memory_order_acquire))
+        writer->drain();
+    changeConfig([enabled](MLogConfig &config) { config.collapseRepeated = enabled; });
+    flushRepeated();
+    QMutexLocker locker(&m_repeatMutex);
+    *m_lastMessage = MLogMessage();
+}
+
+/*!
+ * Returns true if consecutive identical messages are collapsed.
+ *
+ * \sa setCollapseRepeatedMessages
+ */
+bool MLog::isCollapseRepeatedMessages() const
+{
+    return config()->collapseRepeated;
+}
+
+/*!
+ * Enables the flight recorder: the last \a capacity messages of all levels up
+ * to \a level are kept in memory, even when they are above logLevel() (or
+ * category levels) and not logged anywhere. The recorder is written into the
+ * log file (or to stderr, if logging to file is disabled) only when
+ * something goes wrong:
+ *
+ * \li when qFatal() is called
+ * \li on a fatal signal (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT), Unix only
+ * \li when dumpFlightRecorder() is called
+ *
+ * This way production can run at MLog::WarningLog, and still have debug
+ * context of a crash.
+ *
+ * Memory for \a capacity lines of \a maxLineSize bytes is allocated up
+ * front, longer messages are truncated. Calling this function again with the
+ * same sizes only changes \a level; with different ones, a new recorder
+ * replaces the old one. Recording does no I/O, but messages
+ * are formatted (with current message pattern) even if they are not logged.
+ *
+ * Signal handler only writes what is already in the recorder, with
+ * async-signal-safe calls. It runs on an alternate signal stack, so stack
+ * overflows are caught as well - in the thread which called this function,
+ * other threads need an alternate stack of their own (see sigaltstack()). It writes into text log files only, binary and
+ * JSON log files get the recorder on stderr instead. Handlers installed
+ * earlier are called afterwards.
+ *
+ * \code
+ * logger()->setLogLevel(MLog::WarningLog);
+ * logger()->enableFlightRecorder(2000);
+ * \endcode
+ *
+ * \sa disableFlightRecorder
+ */
+void MLog::enableFlightRecorder(const int capacity, const LogLevel level,
+                                const int maxLineSize)
+{
+    MLogFlightRecorder *recorder = nullptr;
+    changeConfig([&](MLogConfig &config) {
+        MLogFlightRecorder *current = config.flightRecorder;
+        if (current && current->hasSize(capacity, maxLineSize)) {
+            // Same size, messages recorded so far are kept
+            recorder = current;
+        } else {
+            recorder = new MLogFlightRecorder(capacity, maxLineSize);
+            if (current)
+                m_configReaders->retire([current]() { delete current; });
+        }
+        config.flightRecorder = recorder;
+        config.flightRecorderLevel = level;
+    });
+    MLogFlightRecorder::setCrashRecorder(recorder);
+    MLogFlightRecorder::installCrashHandler();
+    MLogCategoryLevels::setRecordingLevel(level);
+}
+
+/*!
+ * Disables the flight recorder. Recorded messages are discarded.
+ *
+ * \sa enableFlightRecorder
+ */
+void MLog::disableFlightRecorder()
+{
+    MLogCategoryLevels::setRecordingLevel(NoLog);
+    MLogFlightRecorder::setCrashRecorder(nullptr);
+    // Other threads might still be recording, it is deleted once they are done
+    changeConfig([this](MLogConfig &config) {
+        if (MLogFlightRecorder *recorder = config.flightRecorder)
+            m_configReaders->retire([recorder]() { delete recorder; });
+        config.flightRecorder = nullptr;
+        config.flightRecorderLevel = NoLog;
+    });
+}
+
+/*!
+ * Returns true if the flight recorder is enabled.
+ *
+ * \sa enableFlightRecorder
+ */
+bool MLog::isFlightRecorder() const
+{
+    return config()->flightRecorder != nullptr;
+}
+
+/*!
+ * Writes messages kept by the flight recorder into the log file (or to
+ * stderr if logging to file is disabled), after all messages logged so far.
+ * Recorded messages are kept, so they can be written out again later.
+ *
+ * \sa enableFlightRecorder
+ */
+void MLog::dumpFlightRecorder()
+{
+    const MLogConfigRef config = this->config();
+    MLogFlightRecorder *recorder = config->flightRecorder;
+    if (recorder == nullptr)
+        return;
+
+    if (MLogWriter *writer = m_writer.load(std::memory_order_acquire))
+        writer->drain();
+    writeFlightRecorder(recorder);
+}
+
+/*!
+ * Enables asynchronous logging. From now on, qDebug() and friends only push
+ * the message into a bounded lock-free queue able to hold \a queueSize
+ * messages. Formatting, encoding and writing into file and console is done by
+ * a dedicated writer thread, so logging threads never wait for I/O.
+ *
+ * \a policy decides what happens when the queue is full: logging thread can
+ * either wait for free space (default) or the message can be dropped.
+ *
+ * The writer thread is started on first call and lives until the application
+ * quits, so \a queueSize and \a policy are only honoured on first call.
+ *
+ * qFatal() messages are always written synchronously, after all pending
+ * messages are written out.
+ *
+ * \sa disableAsyncLogging, flush
+ */
+void MLog::enableAsyncLogging(const int queueSize, const OverflowPolicy policy)
+{
+    {
+        QMutexLocker locker(&m_configMutex);
+        if (m_writer.load(std::memory_order_relaxed) == nullptr) {
+            MLogWriter *writer = new MLogWriter(this, queueSize, policy);
+            writer->start();
+            m_writer.store(writer, std::memory_order_release);
+        }
+    }
+
+    changeConfig([](MLogConfig &config) { config.asyncLogging = true; });
+}
+
+/*!
+ * Disables asynchronous logging. Messages still pending in the queue are
+ * written out before this function returns. All subsequent messages will be
+ * written directly by the thread which logs them.
+ *
+ * \sa enableAsyncLogging
+ */
+void MLog::disableAsyncLogging()
+{
+    changeConfig([](MLogConfig &config) { config.asyncLogging = false; });
+    if (MLogWriter *writer = m_writer.load(std::memory_order_acquire))
+        writer->drain();
+}
+
+/*!
+ * Returns true if asynchronous logging is enabled.
+ *
+ * \sa enableAsyncLogging
+ */
+bool MLog::isAsyncLogging() const
+{
+    return config()->asyncLogging;
+}
+
+/*!
+ * Returns the number of messages dropped because the asynchronous queue was
+ * full and MLog::OverflowPolicy::Drop was in use.
+ */
+quint64 MLog::droppedMessageCount() const
+{
+    const MLogWriter *writer = m_writer.load(std::memory_order_acquire);
+    return writer ? writer->droppedCount() : 0;
+}
+
+/*!
+ * Blocks until all messages logged so far have been written. This is only
+ * needed in asynchronous mode or with buffered console output (see
+ * setConsoleFlushPolicy()) - otherwise messages are written before qDebug()
+ * and friends return.
+ */
+void MLog::flush()
+{
+    if (MLogWriter *writer = m_writer.load(std::memory_order_acquire))
+        writer->drain();
+    flushRepeated();
+    flushFile(false);
+
+    m_console->flush();
+    const MLogConfigRef config = this->config();
+    for (MLogSink *sink : config->sinks)
+        sink->flush();
+}
+
+/*!
+ * Enables per-thread buffering of log file output. Normally every logged
+ * message takes MLog's file lock. With thread buffering, each logging thread
+ * appends its formatted debug and info lines to a buffer of its own, and
+ * the buffers are handed off to the log file in batches: when one of them
+ * grows to \a size bytes or, at the latest, \a interval milliseconds after a
+ * line was buffered.
+ *
+ * Lines are numbered from a single global sequence and batches of all
+ * threads are merged in that order, so the log file keeps the order in
+ * which messages were logged. Warnings and more severe messages are never
+ * buffered: they write all buffered lines, and then themselves, right away.
+ *
+ * Only text and JSON log files in synchronous mode are buffered
+ * (asynchronous mode batches writes on its own, see enableAsyncLogging()),
+ * console and sinks are not affected. Buffered lines are written out by
+ * flush(), before qFatal() aborts the application and when the log file is
+ * closed, but are lost if the application crashes.
+ *
+ * \code
+ * logger()->enableThreadBuffering(64 * 1024, 200);
+ * \endcode
+ *
+ * \sa disableThreadBuffering
+ */
+void MLog::enableThreadBuffering(const int size, const int interval)
+{
+    changeConfig([size, interval](MLogConfig &config) {
+        config.threadBufferSize = qMax(size, 1);
+        config.threadBufferInterval = qMax(interval, 0);
+    });
+}
+
+/*!
+ * Disables per-thread buffering of log file output. Lines buffered so far
+ * are written out before this function returns.
+ *
+ * \sa enableThreadBuffering
+ */
+void MLog::disableThreadBuffering()
+{
+    changeConfig([](MLogConfig &config) { config.threadBufferSize = 0; });
+    QMutexLocker locker(&m_mutex);
+    writeStaged();
+}
+
+/*!
+ * Returns true if log file output is buffered per thread.
+ *
+ * \sa enableThreadBuffering
+ */
+bool MLog::isThreadBuffering() const
+{
+    return config()->threadBufferSize > 0;
+}
+
+/*!
+ * Enables (or disables, if \a enabled is false) collecting statistics of
+ * MLog itself, see statistics(). Disabled by default.
+ *
+ * Counters are sharded per thread, so collecting them does not add
+ * contention between logging threads. Measuring write latency costs two
+ * reads of the monotonic clock per message.
+ *
+ * \sa statistics, resetStatistics
+ */
+void MLog::setStatisticsEnabled(const bool enabled)
+{
+    changeConfig([enabled](MLogConfig &config) { config.statistics = enabled; });
+}
+
+/*!
+ * Returns true if statistics are collected.
+ *
+ * \sa setStatisticsEnabled
+ */
+bool MLog::isStatisticsEnabled() const
+{
+    return config()->statistics;
+}
+
+/*!
+ * Returns a snapshot of MLog statistics: logged messages per level and per
+ * category, bytes written into log files, rejected, suppressed and dropped
+ * messages, current depth of the asynchronous queue and a histogram of time
+ * needed to write a message. Safe to call from any thread, e.g. from a
+ * timer exporting MLogStatistics::toJson() to a monitoring system.
+ *
+ * Message counters and the histogram are only updated while statistics are
+ * enabled, see setStatisticsEnabled(). Messages disabled by log levels are
+ * filtered out by Qt before they reach MLog, they are not counted.
+ *
+ * Counters are read one by one while other threads keep logging, so the
+ * snapshot is not exactly consistent.
+ */
+MLogStatistics MLog::statistics() const
+{
+    MLogStatistics result;
+    m_statistics->collect(result);
+    for (const MLogCallSite *site : m_callSites->sites()) {
+        const quint64 count = site->categoryCount.load(std::memory_order_relaxed);
+        // Categories of the same name can be defined more than once
+        if (count > 0)
+            result.categories[QString::fromUtf8(site->category ? site->category
+                                                               : "default")] += count;
+    }
+    result.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    result.suppressed = suppressedMessageCount();
+    result.dropped = droppedMessageCount();
+    const MLogWriter *writer = m_writer.load(std::memory_order_acquire);
+    result.queueDepth = writer ? writer->queueDepth() : 0;
+    return result;
+}
+
+/*!
+ * Sets all statistics counters to 0. Suppressed and dropped message counts
+ * are kept, see suppressedMessageCount() and droppedMessageCount().
+ *
+ * \sa statistics
+ */
+void MLog::resetStatistics()
+{
+    m_statistics->reset();
+    for (MLogCallSite *site : m_callSites->sites())
+        site->categoryCount.store(0, std::memory_order_relaxed);
+    m_bytesWritten.store(0, std::memory_order_relaxed);
+}
+
+/*!
+ * Enables (or disables, if \a enabled is false) call site profiling: MLog
+ * counts messages, and bytes of their UTF-8 encoded text, logged from every
+ * place in code. The biggest talkers can be found with topCallSites(); when
+ * MLog is destroyed, \a reportSize of them are written into the log as well.
+ *
+ * Call sites are interned in a lock-free registry on first use, later
+ * messages only hash QMessageLogContext strings and increment two atomic
+ * counters. Call sites are only told apart when QT_MESSAGELOGCONTEXT is
+ * defined (or in debug builds), otherwise Qt does not pass file, line and
+ * function, and all messages of a category are counted together.
+ *
+ * \code
+ * logger()->setCallSiteProfiling(true, 10);
+ * \endcode
+ *
+ * \sa topCallSites
+ */
+void MLog::setCallSiteProfiling(const bool enabled, const int reportSize)
+{
+    changeConfig([enabled, reportSize](MLogConfig &config) {
+        config.profiling = enabled;
+        config.profilingReportSize = reportSize;
+    });
+}
+
+/*!
+ * Returns true if call site profiling is enabled.
+ *
+ * \sa setCallSiteProfiling
+ */
+bool MLog::isCallSiteProfiling() const
+{
+    return config()->profiling;
+}
+
+/*!
+ * Returns \a count call sites which logged the most messages, sorted by
+ * number of messages (most first).
+ *
+ * \sa setCallSiteProfiling
+ */
+QVector<MLogCallSiteStatistics> MLog::topCallSites(const int count) const
+{
+    QVector<MLogCallSiteStatistics> result;
+    for (const MLogCallSite *site : m_callSites->sites()) {
+        const quint64 messages = site->messageCount.load(std::memory_order_relaxed);
+        if (messages == 0)
+            continue;
+
+        MLogCallSiteStatistics statistics;
+        statistics.file = QString::fromUtf8(site->file);
+        statistics.line = site->line;
+        statistics.function = QString::fromUtf8(site->function);
+        statistics.category = QString::fromUtf8(site->category);
+        statistics.messages = messages;
+        statistics.size = site->messageSize.load(std::memory_order_relaxed);
+        result.append(statistics);
+    }
+
+    std::sort(result.begin(), result.end(), [](const MLogCallSiteStatistics &left,
+                                               const MLogCallSiteStatistics &right) {
+        return left.messages > right.messages;
+    });
+    if (count >= 0 && result.size() > count)
+        result.resize(count);
+    return result;
+}
+
+/*!
+ * Writes \a count top call sites into all outputs, as raw messages.
+ *
+ * \sa setCallSiteProfiling
+ */
+void MLog::writeCallSiteReport(const int count)
+{
+    const QVector<MLogCallSiteStatistics> sites = topCallSites(count);
+    if (sites.isEmpty())
+        return;
+
+    writeRaw(QtInfoMsg, QStringLiteral("Top %1 log call sites (messages, bytes, "
+                                       "call site):\n").arg(sites.size()));
+    for (const MLogCallSiteStatistics &site : sites) {
+        const QString location = site.file.isEmpty()
+                ? QStringLiteral("[%1]").arg(site.category)
+                : QStringLiteral("%1:%2 %3 [%4]").arg(site.file).arg(site.line)
+                  .arg(site.function, site.category);
+        writeRaw(QtInfoMsg, QStringLiteral("%1 %2 %3\n").arg(site.messages, 10)
+                 .arg(site.size, 12).arg(location));
+    }
+}
+
+/*!
+ * Standard Qt messageHandler. MLog only adds the option to write to file
+ * (use enableLogToFile() to, well, enable writing logs to a file) and log level
+ * controls (see setLogLevel() and setCategoryLogLevels() for more details).
+ *
+ * \a type, \a context, \a message have exactly the same meaning as in Qt's
+ * built-in message handler and behave the same.
+ *
+ * MLog respects categorized logging settings (qCDebug() and friends).
+ *
+ * In asynchronous mode the message is only queued here and written out later
+ * by the writer thread (see enableAsyncLogging()).
+ *
+ * \sa enableLogToFile, setLogLevel, isMessageAllowed
+ */
+void MLog::messageHandler(QtMsgType type, const QMessageLogContext &context,
+                          const QString &message)
+{
+    logger()->handleMessage(type, context, message, QByteArray());
+}
+
+/*!
+ * Common part of messageHandler() and logUtf8(): filters the message and
+ * writes it (or queues it). Text is either in \a message or, encoded as
+ * UTF-8, in \a utf8.
+ */
+void MLog::handleMessage(QtMsgType type, const QMessageLogContext &context,
+                         const QString &message, const QByteArray &utf8)
+{
+    // Other levels are applied by the category filter, which can not disable
+    // qFatal()
+    if (type == QtFatalMsg && isMessageAllowed(type) == false)
+        return;
+
+    const MLogConfigRef config = this->config();
+    MLogFlightRecorder *recorder = config->flightRecorder;
+    // With flight recorder, categories are enabled up to recording level and
+    // the real level has to be checked here
+    bool allowed = recorder == nullptr || type == QtFatalMsg
+            || MLogCategoryLevels::isEnabled(context.category, type);
+    const bool recording = recorder
+            && MLogCategoryLevels::messageLevel(type) <= config->flightRecorderLevel;
+
+    // Decided before anything is formatted, so rejected messages cost almost
+    // nothing
+    int samplingRate = 1;
+    if (allowed && config->sampling && type != QtFatalMsg) {
+        samplingRate = MLogCategoryLevels::samplingRate(context.category, type);
+        if (samplingRate > 1 && MLogCategoryLevels::sample(samplingRate) == false)
+            allowed = false;
+    }
+
+    if (allowed == false && config->statistics)
+        m_statistics->addRejected();
+
+    quint64 suppressed = 0;
+    if (allowed && config->rateLimitInterval > 0 && type != QtFatalMsg
+            && isRateLimited(config.get(), context, suppressed)) {
+        allowed = false;
+    }
+    if (allowed == false && recording == false)
+        return;
+
+    MLogMessage entry;
+    entry.type = type;
+    entry.line = context.line;
+    entry.file = context.file;
+    entry.function = context.function;
+    entry.category = context.category;
+    entry.timestamp = currentTimestamp(config.get());
+    entry.threadId = MLogFormatter::currentThreadId();
+    if (needsThreadPointer(config.get()))
+        entry.threadPointer = quintptr(QThread::currentThread());
+    entry.message = message;
+    if (utf8.isNull() == false) {
+        // Caller's buffer is usually reused for its next message, queued
+        // messages need a copy of their own
+        entry.utf8 = config->asyncLogging ? QByteArray(utf8.constData(), utf8.size())
+                                          : utf8;
+    }
+    if (const QVector<MLogField> *fields = MLogRecord::pendingFields())
+        entry.fields = *fields;
+
+    if (recording)
+        record(recorder, entry);
+    if (allowed == false)
+        return;
+    if (config->statistics)
+        countMessage(context.category, type);
+    if (config->profiling)
+        profileCallSite(context, utf8.isNull()
+                        ? mlog::utf8Size(message.constData(), message.size())
+                        : utf8.size());
+
+    if (samplingRate > 1) {
+        MLogField field;
+        field.key = "sampled";
+        field.integer = samplingRate;
+        entry.fields.append(field);
+    }
+    if (suppressed > 0) {
+        MLogField field;
+        field.key = "suppressed";
+        field.integer = qint64(suppressed);
+        entry.fields.append(field);
+    }
+
+    if (config->asyncLogging) {
+        if (type != QtFatalMsg) {
+            detachContext(entry);
+            m_writer.load(std::memory_order_acquire)->enqueue(std::move(entry));
+            return;
+        }
+
+        // Application is about to abort, write everything out right now
+        flush();
+    }
+
+    output(entry);
+    if (type == QtFatalMsg) {
+        flushFile(false);
+        // Console output may be buffered even if this message was not printed
+        m_console->flush();
+        if (recorder) {
+            writeFlightRecorder(recorder);
+            MLogFlightRecorder::markDumped();
+        }
+    }
+}
+
+/*!
+ * Formats \a message and keeps it in flight \a recorder.
+ *
+ * \sa enableFlightRecorder
+ */
+void MLog::record(MLogFlightRecorder *recorder, const MLogMessage &message)
+{
+    static thread_local QByteArray line;
+    if (line.capacity() == 0)
+        line.reserve(1024);
+    line.resize(0);
+
+    m_formatter.load(std::memory_order_acquire)->format(line, message);
+    recorder->record(line);
+}
+
+/*!
+ * Writes lines kept by flight \a recorder into the log file, in its format,
+ * or to stderr if logging to file is disabled.
+ *
+ * \sa dumpFlightRecorder
+ */
+void MLog::writeFlightRecorder(MLogFlightRecorder *recorder)
+{
+    const QVector<QByteArray> lines = recorder->lines();
+    const MLogConfigRef config = this->config();
+    if (config->logToFile == false) {
+        m_console->flush();
+        fputs(MLogFlightRecorder::header(), stderr);
+        for (const QByteArray &line : lines) {
+            fwrite(line.constData(), 1, size_t(line.size()), stderr);
+            fputc('\n', stderr);
+        }
+        fputs(MLogFlightRecorder::footer(), stderr);
+        fflush(stderr);
+        return;
+    }
+
+    // Written as raw messages, just like writeRaw() does
+    MLogMessage entry;
+    entry.type = QtDebugMsg;
+    entry.raw = true;
+    entry.timestamp = currentTimestamp(config.get());
+    const auto writeLine = [&](const QByteArray &text) {
+        const FileFormat format = m_openFileFormat.load(std::memory_order_relaxed);
+        if (format == FileFormat::Text) {
+            write(QByteArray(text + '\n'), FileFormat::Text, entry.timestamp);
+            return;
+        }
+
+        entry.message = QString::fromUtf8(text);
+        if (format == FileFormat::Binary)
+            writeBinary(entry);
+        else
+            writeJson(config.get(), entry);
+    };
+
+    const QByteArray header(MLogFlightRecorder::header());
+    const QByteArray footer(MLogFlightRecorder::footer());
+    writeLine(header.left(header.size() - 1));
+    for (const QByteArray &line : lines)
+        writeLine(line);
+    writeLine(footer.left(footer.size() - 1));
+    flushFile(false);
+}
+
+/*!
+ * Returns current configuration snapshot. Safe to call from any thread, the
+ * snapshot stays valid as long as the returned reference exists - keep it on
+ * the stack for as long as the snapshot is used.
+ */
+MLogConfigRef MLog::config() const
+{
+    return MLogConfigRef(m_configReaders, m_config);
+}
+
+/*!
+ * Publishes a new configuration snapshot: a copy of the current one, modified
+ * by \a change. Threads which are logging right now keep using the snapshot
+ * they have already loaded, so the old snapshot is retired and deleted on the
+ * worker thread once none of them can use it anymore.
+ *
+ * \sa reclaimConfigs
+ */
+template <typename Change>
+void MLog::changeConfig(Change change)
+{
+    QMutexLocker locker(&m_configMutex);
+    const MLogConfig *old = m_config.load(std::memory_order_relaxed);
+    MLogConfig *config = new MLogConfig(*old);
+    change(*config);
+    m_config.store(config, std::memory_order_seq_cst);
+    m_configReaders->retire([old]() { delete old; });
+    scheduleReclaim();
+}
+
+/*!
+ * Makes sure reclaimConfigs() is going to run. Has to be called with
+ * m_configMutex locked.
+ */
+void MLog::scheduleReclaim()
+{
+    if (m_reclaimScheduled == false) {
+        m_reclaimScheduled = true;
+        m_worker->postDelayed([this]() { reclaimConfigs(); }, configReclaimInterval);
+    }
+}
+
+/*!
+ * Deletes retired configuration snapshots which no thread uses anymore and
+ * schedules itself again if any are left. Runs on the worker thread.
+ *
+ * \sa changeConfig
+ */
+void MLog::reclaimConfigs()
+{
+    QMutexLocker locker(&m_configMutex);
+    m_reclaimScheduled = false;
+    if (m_configReaders->reclaim())
+        scheduleReclaim();
+}
+
+/*!
+ * Returns true if MLog's message pattern or pattern of any sink in \a config
+ * uses %{qthreadptr}.
+ */
+bool MLog::needsThreadPointer(const MLogConfig *config) const
+{
+    if (m_formatter.load(std::memory_order_acquire)->needsThreadPointer())
+        return true;
+
+    for (const MLogSink *sink : config->sinks) {
+        const MLogFormatter *formatter = sink->formatter();
+        if (formatter && formatter->needsThreadPointer())
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Returns current time in milliseconds since epoch, read from the clock set in
+ * \a config and truncated to requested precision.
+ */
+qint64 MLog::currentTimestamp(const MLogConfig *config) const
+{
+    const qint64 now = MLogClock::now(config->clockSource);
+    if (config->timestampPrecision == TimestampPrecision::Seconds)
+        return now - now % 1000;
+    return now;
+}
+
+/*!
+ * Returns true if message logged from \a context exceeds the rate limit and
+ * should be dropped. Otherwise \a suppressed is set to the number of
+ * messages dropped at the same call site (or category) since the last one
+ * which passed. Safe to call from any thread, never locks (except when a
+ * call site logs for the first time).
+ *
+ * \sa enableRateLimit
+ */
+bool MLog::isRateLimited(const MLogConfig *config, const QMessageLogContext &context,
+                         quint64 &suppressed)
+{
+    MLogCallSite *site = nullptr;
+    if (config->rateLimitScope == RateLimitScope::Category)
+        site = m_callSites->intern(nullptr, 0, nullptr, context.category);
+    else
+        site = m_callSites->intern(context.file, context.line, context.function,
+                                   context.category);
+    // Registry is full, no limit
+    if (site == nullptr)
+        return false;
+
+    MLogTokenBucket &bucket = site->rateLimit;
+    if (bucket.acquire(MLogTokenBucket::now(), config->rateLimitInterval,
+                       config->rateLimitTolerance) == false) {
+        bucket.suppressed.fetch_add(1, std::memory_order_relaxed);
+        m_suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (bucket.suppressed.load(std::memory_order_relaxed) > 0)
+        suppressed = bucket.suppressed.exchange(0, std::memory_order_relaxed);
+    return false;
+}
+
+/*!
+ * Formats \a message and writes it into the log file and console, unless it
+ * only repeats the previous message and repeated messages are collapsed.
+ * Called either directly by messageHandler() and writeRaw() or, in
+ * asynchronous mode, by the writer thread.
+ *
+ * \sa setCollapseRepeatedMessages
+ */
+void MLog::output(const MLogMessage &message)
+{
+    const MLogConfigRef config = this->config();
+    if (message.raw == false && config->collapseRepeated && collapseRepeated(message))
+        return;
+
+    if (config->statistics == false) {
+        outputMessage(message);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    outputMessage(message);
+    m_statistics->addLatency(timer.nsecsElapsed());
+}
+
+/*!
+ * Counts a logged message of \a type in \a category.
+ *
+ * \sa setStatisticsEnabled
+ */
+void MLog::countMessage(const char *category, const QtMsgType type)
+{
+    m_statistics->addMessage(type);
+    if (MLogCallSite *site = m_callSites->intern(nullptr, 0, nullptr, category))
+        site->categoryCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ * Counts message of \a size bytes (length of its text encoded as UTF-8)
+ * logged from call site described by \a context.
+ *
+ * \sa setCallSiteProfiling
+ */
+void MLog::profileCallSite(const QMessageLogContext &context, const qsizetype size)
+{
+    MLogCallSite *site = m_callSites->intern(context.file, context.line,
+                                             context.function, context.category);
+    if (site) {
+        site->messageCount.fetch_add(1, std::memory_order_relaxed);
+        site->messageSize.fetch_add(quint64(size), std::memory_order_relaxed);
+    }
+}
+
+/*!
+ * Makes context strings of \a message independent of the logging code, so
+ * that the message can be kept after the message handler returns. Strings
+ * are taken from the call site registry, which keeps copies of its own, or
+ * copied into the message if the registry is full.
+ */
+void MLog::detachContext(MLogMessage &message)
+{
+    if (message.file == nullptr && message.function == nullptr
+            && message.category == nullptr) {
+        return;
+    }
+
+    if (const MLogCallSite *site = m_callSites->intern(message.file, message.line,
+                                                       message.function,
+                                                       message.category)) {
+        message.file = site->file;
+        message.function = site->function;
+        message.category = site->category;
+        return;
+    }
+
+    // Null strings stay null, the others are copied one after another
+    const char *strings[] = { message.file, message.function, message.category };
+    int sizes[3] = {};
+    int total = 0;
+    for (int i = 0; i < 3; ++i) {
+        sizes[i] = strings[i] ? int(qstrlen(strings[i])) + 1 : 0;
+        total += sizes[i];
+    }
+    message.context.resize(total);
+    char *data = message.context.data();
+    const char *copies[3] = {};
+    for (int i = 0; i < 3; ++i) {
+        if (strings[i] == nullptr)
+            continue;
+        memcpy(data, strings[i], size_t(sizes[i]));
+        copies[i] = data;
+        data += sizes[i];
+    }
+    message.file = copies[0];
+    message.function = copies[1];
+    message.category = copies[2];
+}
+
+/*!
+ * Returns true if \a message is the same as the previous one (same type,
+ * category and text), which means it should only be counted. Otherwise
+ * writes out how many times the previous message was repeated, if it was.
+ */
+bool MLog::collapseRepeated(const MLogMessage &message)
+{
+    QMutexLocker locker(&m_repeatMutex);
+    MLogMessage &last = *m_lastMessage;
+    if (message.type == last.type && qstrcmp(message.category, last.category) == 0
+            && message.fields.isEmpty() && last.fields.isEmpty()
+            && message.message == last.message && message.utf8 == last.utf8
+            && (last.message.isNull() == false || last.utf8.isNull() == false)) {
+        if (++m_repeatCount == 1) {
+            // Reported in time, even if nothing else is logged
+            m_worker->postDelayed([this]() { flushRepeated(); }, 1000);
+        }
+        return true;
+    }
+
+    if (m_repeatCount > 0) {
+        MLogMessage summary = last;
+        summary.timestamp = message.timestamp;
+        summary.message = QStringLiteral("Last message repeated %1 times").arg(m_repeatCount);
+        m_repeatCount = 0;
+        outputMessage(summary);
+    }
+    last = message;
+    // Written out later, by flushRepeated()
+    detachContext(last);
+    return false;
+}
+
+/*!
+ * Writes out how many times the last message was repeated, if it was, so
+ * that the count is not held back until a different message is logged.
+ */
+void MLog::flushRepeated()
+{
+    QMutexLocker locker(&m_repeatMutex);
+    if (m_repeatCount == 0)
+        return;
+
+    MLogMessage summary = *m_lastMessage;
+    summary.timestamp = currentTimestamp(config().get());
+    summary.message = QStringLiteral("Last message repeated %1 times").arg(m_repeatCount);
+    m_repeatCount = 0;
+    outputMessage(summary);
+}
+
+/*!
+ * Writes \a message into log file, console and attached sinks.
+ */
+void MLog::outputMessage(const MLogMessage &message)
+{
+    // One line buffer per thread, reused for every message
+    static thread_local QByteArray line;
+    if (line.capacity() == 0)
+        line.reserve(1024);
+    line.resize(0);
+
+    // Whole message is written according to the same snapshot
+    const MLogConfigRef config = this->config();
+    const QtMsgType type = message.type;
+    const FileFormat fileFormat = m_openFileFormat.load(std::memory_order_relaxed);
+    const bool textFile = config->logToFile && fileFormat == FileFormat::Text;
+    if (config->logToFile && fileFormat == FileFormat::Binary)
+        writeBinary(message);
+    else if (config->logToFile && fileFormat == FileFormat::Json)
+        writeJson(config.get(), message);
+
+    if (message.raw) {
+        mlog::appendUtf8(line, message.message);
+        if (textFile)
+            write(line, FileFormat::Text, message.timestamp);
+        if (isMessageAllowed(type))
+            m_console->output(type, line);
+        writeSinks(message, config->sinks, nullptr, line);
+    } else {
+        // Message is only formatted if somebody is going to read it now
+        const MLogFormatter *formatter = m_formatter.load(std::memory_order_acquire);
+        if (textFile || config->logToConsole) {
+            formatter->format(line, message);
+            line.append('\n');
+            if (textFile && stage(config.get(), message, line, FileFormat::Text) == false)
+                write(line, FileFormat::Text, message.timestamp);
+            if (config->logToConsole)
+                m_console->output(type, line);
+        }
+
+        writeSinks(message, config->sinks, line.isEmpty() ? nullptr : formatter, line);
+    }
+
+    if (config->logToFile && (type == QtCriticalMsg || type == QtFatalMsg)
+            && m_syncOnCritical.load(std::memory_order_relaxed)) {
+        flushFile(true);
+    }
+}
+
+/*!
+ * Writes \a message into attached \a sinks which accept it. \a line
+ * contains the message already formatted by \a formatter (if not null), or
+ * the text of a raw message.
+ *
+ * Message is formatted at most once per distinct formatter, sinks using the
+ * same message pattern share it.
+ *
+ * \sa addSink
+ */
+void MLog::writeSinks(const MLogMessage &message, const QVector<MLogSink *> &sinks,
+                      const MLogFormatter *formatter, const QByteArray &line)
+{
+    if (sinks.isEmpty())
+        return;
+
+    // All formats rendered for this message, one after another
+    static thread_local QByteArray buffer;
+    struct Rendered {
+        const MLogFormatter *formatter;
+        int offset;
+        int size;
+    };
+    QVarLengthArray<Rendered, 4> rendered;
+    buffer.resize(0);
+
+    for (MLogSink *sink : sinks) {
+        if (sink->isMessageAllowed(message.type) == false)
+            continue;
+
+        if (message.raw) {
+            sink->output(message.type, line);
+            continue;
+        }
+
+        const MLogFormatter *sinkFormatter = sink->formatter();
+        if (sinkFormatter == nullptr)
+            sinkFormatter = m_formatter.load(std::memory_order_acquire);
+        if (sinkFormatter == formatter) {
+            sink->output(message.type, line);
+            continue;
+        }
+
+        auto it = std::find_if(rendered.begin(), rendered.end(),
+                               [sinkFormatter](const Rendered &entry) {
+            return entry.formatter == sinkFormatter;
+        });
+        if (it == rendered.end()) {
+            const int offset = buffer.size();
+            sinkFormatter->format(buffer, message);
+            buffer.append('\n');
+            rendered.append({ sinkFormatter, offset, buffer.size() - offset });
+            it = rendered.end() - 1;
+        }
+        sink->output(message.type, QByteArray::fromRawData(buffer.constData() + it->offset,
+                                                           it->size));
+    }
+}
+
+/*!
+ * Writes UTF-8 encoded \a data into current log file, unless the file was
+ * reopened in a different \a format in the meantime.
+ *
+ * This function first checks whether log file is open and writable.
+ *
+ * Data is collected in a long-lived buffer. In synchronous mode the buffer is
+ * written out right away (one write per message). In asynchronous mode it is
+ * only written out when it grows above 64 KiB or when the writer thread runs
+ * out of messages, so under load the file is written in large blocks.
+ */
+void MLog::write(const QByteArray &data, const FileFormat format,
+                 const qint64 timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+    // Lines buffered by logging threads were logged earlier
+    writeStaged();
+    if (m_openFileFormat.load(std::memory_order_relaxed) != format)
+        return;
+
+    if (m_logFile.isOpen() && m_logFile.isWritable()) {
+        rotateIfNeeded(data.size(), timestamp);
+        m_fileBuffer.append(data);
+        m_fileSize += data.size();
+        flushFileBufferIfNeeded();
+    }
+}
+
+/*!
+ * Writes \a message into current (binary) log file. The record is encoded
+ * before taking the lock. Definition of the message's call site is written
+ * in front of it, if this is the first message from that call site in this
+ * file.
+ *
+ * \sa setFileFormat
+ */
+void MLog::writeBinary(const MLogMessage &message)
+{
+    static thread_local QByteArray record;
+    if (record.capacity() == 0)
+        record.reserve(256);
+    record.resize(0);
+
+    MLogCallSite *site = nullptr;
+    if (message.raw) {
+        MLogBinary::appendRaw(record, message);
+    } else {
+        site = m_callSites->intern(message.file, message.line,
+                                   message.function, message.category);
+        MLogBinary::appendMessage(record, site ? site->id : 0, message);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_openFileFormat.load(std::memory_order_relaxed) != FileFormat::Binary)
+        return;
+
+    if (m_logFile.isOpen() && m_logFile.isWritable()) {
+        rotateIfNeeded(record.size(), message.timestamp);
+
+        const int bufferSize = m_fileBuffer.size();
+        if (site && site->fileGeneration != m_fileGeneration) {
+            MLogBinary::appendCallSite(m_fileBuffer, *site);
+            site->fileGeneration = m_fileGeneration;
+        }
+        m_fileBuffer.append(record);
+        m_fileSize += m_fileBuffer.size() - bufferSize;
+        flushFileBufferIfNeeded();
+    }
+}
+
+/*!
+ * Writes \a message into current (JSON) log file, as a single line. The
+ * record is encoded into a per-thread buffer before taking the lock.
+ *
+ * \sa setFileFormat
+ */
+void MLog::writeJson(const MLogConfig *config, const MLogMessage &message)
+{
+    static thread_local QByteArray record;
+    if (record.capacity() == 0)
+        record.reserve(1024);
+    record.resize(0);
+
+    mlog::appendJsonRecord(record, message);
+    record.append('\n');
+    if (stage(config, message, record, FileFormat::Json) == false)
+        write(record, FileFormat::Json, message.timestamp);
+}
+
+/*!
+ * Keeps \a line of \a message, already formatted for the log file in
+ * \a format, in the calling thread's staging buffer. Returns false if thread
+ * buffering does not apply to the message, which means it has to be written
+ * right away.
+ *
+ * When the buffer is full, lines of all threads are written out now.
+ * Otherwise they are written out by the background worker, at most the
+ * configured interval later.
+ *
+ * \sa enableThreadBuffering
+ */
+bool MLog::stage(const MLogConfig *config, const MLogMessage &message,
+                 const QByteArray &line, const FileFormat format)
+{
+    if (config->threadBufferSize <= 0 || config->asyncLogging || message.raw
+            || (message.type != QtDebugMsg && message.type != QtInfoMsg)) {
+        return false;
+    }
+
+    if (m_staging->append(line, format, message.timestamp, config->threadBufferSize)) {
+        QMutexLocker locker(&m_mutex);
+        writeStaged();
+    } else if (m_stagingScheduled.load(std::memory_order_relaxed) == false
+               && m_stagingScheduled.exchange(true) == false) {
+        m_worker->postDelayed([this]() {
+            m_stagingScheduled.store(false);
+            QMutexLocker locker(&m_mutex);
+            writeStaged();
+        }, config->threadBufferInterval);
+    }
+    return true;
+}
+
+/*!
+ * Moves lines kept in staging buffers of all threads into the file buffer,
+ * in the order in which they were logged. Must be called with m_mutex
+ * locked.
+ *
+ * \sa enableThreadBuffering
+ */
+void MLog::writeStaged()
+{
+    // Rotation closes the file, which would write staged lines again
+    if (m_writingStaged || m_staging->isEmpty())
+        return;
+
+    m_writingStaged = true;
+    m_staging->take();
+    const QByteArray &data = m_staging->takenData();
+    if (m_logFile.isOpen() && m_logFile.isWritable()) {
+        for (const MLogStaging::Line &line : m_staging->takenLines()) {
+            // Unless the file was reopened in a different format
+            if (line.format != m_openFileFormat.load(std::memory_order_relaxed))
+                continue;
+
+            rotateIfNeeded(line.size, line.timestamp);
+            m_fileBuffer.append(data.constData() + line.offset, line.size);
+            m_fileSize += line.size;
+        }
+        flushFileBufferIfNeeded();
+    }
+    m_writingStaged = false;
+}
+
+/*!
+ * Writes out the file buffer if required by file flush policy: with the
+ * default policy right away in synchronous mode, or once it grows above
+ * 64 KiB in asynchronous mode. Must be called with m_mutex locked, after
+ * data was added to the buffer.
+ *
+ * \sa setFileFlushPolicy
+ */
+void MLog::flushFileBufferIfNeeded()
+{
+    bool flushNow = m_fileBuffer.size() >= fileBufferSize;
+    switch (m_fileFlushPolicy) {
+    case FileFlushPolicy::Default:
+        flushNow = flushNow || config()->asyncLogging == false;
+        break;
+    case FileFlushPolicy::Buffered:
+        break;
+    case FileFlushPolicy::Periodic:
+        if (m_fileFlushSize > 0 && m_fileBuffer.size() >= m_fileFlushSize)
+            flushNow = true;
+        if (m_fileFlushInterval <= 0 || (m_fileBufferTimer.isValid()
+                && m_fileBufferTimer.hasExpired(m_fileFlushInterval))) {
+            flushNow = true;
+        }
+        if (flushNow == false && m_fileBufferTimer.isValid() == false) {
+            m_fileBufferTimer.start();
+            // Written out in time even if nothing else is logged
+            m_worker->postDelayed([this]() { flushFile(false); }, m_fileFlushInterval);
+        }
+        break;
+    }
+
+    if (flushNow)
+        flushFileBuffer();
+}
+
+/*!
+ * Writes out data collected in the file buffer. Must be called with m_mutex
+ * locked.
+ *
+ * If preallocation is enabled, disk space for the data is allocated first.
+ */
+void MLog::flushFileBuffer()
+{
+    m_fileBufferTimer.invalidate();
+    if (m_fileBuffer.isEmpty())
+        return;
+
+    if (m_logFile.isOpen()) {
+        const qint64 end = m_fileEnd + m_fileBuffer.size();
+        if (m_preallocationChunk > 0 && end > m_preallocatedEnd) {
+            const qint64 chunks = (end + m_preallocationChunk - 1) / m_preallocationChunk;
+            const qint64 preallocatedEnd = chunks * m_preallocationChunk;
+            // If it is not supported, the file simply grows as usual
+            if (MLogStorage::preallocate(m_logFile, m_fileEnd, preallocatedEnd - m_fileEnd))
+                m_preallocatedEnd = preallocatedEnd;
+        }
+
+        const qint64 written = m_logFile.write(m_fileBuffer);
+        if (written > 0) {
+            m_fileEnd += written;
+            m_bytesWritten.fetch_add(quint64(written), std::memory_order_relaxed);
         }
     }
-    return QString();
+    m_fileBuffer.resize(0);
+}
+
+/*!
+ * Locks m_mutex and writes out data collected in the file buffer, unless
+ * file flush policy says otherwise. Used by the asynchronous writer whenever
+ * it runs out of messages.
+ *
+ * \sa setFileFlushPolicy
+ */
+void MLog::writePendingOutput()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_fileFlushPolicy == FileFlushPolicy::Default)
+        flushFileBuffer();
+}
+
+/*!
+ * Locks m_mutex and writes out data collected in the file buffer, whatever
+ * the file flush policy. If \a sync is true, the log file is also
+ * synchronized to disk.
+ *
+ * \sa setSyncOnCritical
+ */
+void MLog::flushFile(const bool sync)
+{
+    QMutexLocker locker(&m_mutex);
+    writeStaged();
+    flushFileBuffer();
+    if (sync && m_logFile.isOpen())
+        MLogStorage::sync(m_logFile);
+}
+
+/*!
+ * Opens currentLogPath() for writing in \a format, see setFileFormat(). If
+ * \a append is true, new messages are added at the end of the file,
+ * otherwise it is truncated. Must be called with m_mutex locked.
+ */
+bool MLog::openLogFile(const FileFormat format, const bool append)
+{
+    const bool binary = (format == FileFormat::Binary);
+    m_logFile.setFileName(m_currentLogPath);
+    // MLog does its own buffering, see write()
+    QIODevice::OpenMode mode = QFile::WriteOnly | QFile::Unbuffered;
+    if (append)
+        mode |= QFile::Append;
+    if (!binary)
+        mode |= QFile::Text;
+    if (!m_logFile.open(mode))
+        return false;
+
+    // Call sites have to be defined again in the new file
+    ++m_fileGeneration;
+    m_openFileFormat.store(format);
+    m_fileSize = 0;
+    m_fileEnd = m_logFile.size();
+    m_preallocatedEnd = m_fileEnd;
+    // Crash handler can only write text
+    MLogFlightRecorder::setCrashOutput(format == FileFormat::Text ? m_logFile.handle() : 2);
+    m_fileOpenedAt = currentTimestamp(config().get());
+    if (binary && !append) {
+        MLogBinary::appendHeader(m_fileBuffer, messagePattern(), m_appName,
+                                 QCoreApplication::applicationPid());
+        flushFileBuffer();
+    }
+    return true;
+}
+
+/*!
+ * Writes out the file buffer and closes current log file, truncating it to
+ * its real size if space was preallocated for it. Must be called with
+ * m_mutex locked.
+ *
+ * \sa setFilePreallocation
+ */
+void MLog::closeLogFile()
+{
+    MLogFlightRecorder::setCrashOutput(2);
+    writeStaged();
+    flushFileBuffer();
+    if (m_preallocatedEnd > m_fileEnd)
+        MLogStorage::trim(m_logFile, m_fileEnd);
+    m_preallocatedEnd = m_fileEnd;
+    m_logFile.close();
 }
 
 /*!
- * Removes last log file matching set RotationType in \a logsDir with \a appName.
+ * Rotates current log file if writing \a pendingBytes more into it would
+ * exceed the size limit, or if it is too old at \a timestamp. Must be called
+ * with m_mutex locked, before the message is added to the file buffer.
+ *
+ * \sa setLogRotation
  */
-void MLog::removeLastLog(const QString &appName, const QDir &logsDir)
+void MLog::rotateIfNeeded(const qint64 pendingBytes, const qint64 timestamp)
 {
-    const QStringList logFilter(appName + "-*" + m_fileExt);
-    const auto files = logsDir.entryList(logFilter, QDir::Files, QDir::Reversed);
-    const auto logFilePath = logsDir.absolutePath();
-    QString lastLog;
+    const bool tooBig = m_maxFileSize > 0 && m_fileSize > 0
+            && m_fileSize + pendingBytes > m_maxFileSize;
+    const bool tooOld = m_maxFileAge > 0
+            && timestamp - m_fileOpenedAt >= qint64(m_maxFileAge) * 1000;
+    if (tooBig || tooOld)
+        rotateCurrentFile(timestamp);
+}
 
+/*!
+ * Closes current log file and opens a new one. Must be called with m_mutex
+ * locked.
+ *
+ * Only the minimum is done here: closed file is renamed (Consequent rotation)
+ * or simply left behind (DateTime rotation). Shifting older logs and removing
+ * the ones above the limit is posted to the background worker.
+ */
+void MLog::rotateCurrentFile(const qint64 timestamp)
+{
+    const MLogRotation rotation(m_logDirectory, m_appName, m_rotationType, m_maxLogs);
+    QString closedLogPath;
+    QString newLogPath;
     if (m_rotationType == MLog::RotationType::Consequent) {
-        const QRegularExpression expr("(" + appName + "-previous-)([1-9][0-9]*)"
-                                      + m_fileExt);
-        int max = 0;
-
-        for(const auto &file : qAsConst(files)) {
-            const auto match = expr.match(file);
-            if (match.hasMatch()) {
-                const int index = match.captured(2).toInt();
-
-                if (index > max) {
-                    max = index;
-                    lastLog = file;
-                }
-            }
+        closedLogPath = rotation.rotatedLogPath(timestamp, ++m_rotationCount);
+        newLogPath = m_currentLogPath;
+    } else {
+        closedLogPath = m_currentLogPath;
+        newLogPath = rotation.currentLogPath(timestamp);
+        // Names have 1 second resolution, try again later
+        if (newLogPath == m_currentLogPath)
+            return;
+    }
+
+    closeLogFile();
+
+    const FileFormat format = m_openFileFormat.load();
+    if (closedLogPath != m_currentLogPath
+            && QFile::rename(m_currentLogPath, closedLogPath) == false) {
+        // Could not move the file away, keep appending to it
+        openLogFile(format, true);
+        return;
+    }
+
+    m_currentLogPath = newLogPath;
+    if (m_rotationType == MLog::RotationType::DateTime)
+        m_previousLogPath = closedLogPath;
+    else
+        m_previousLogPath = rotation.previousLogPath();
+    openLogFile(format, false);
+
+    m_worker->post([rotation, closedLogPath, newLogPath]() {
+        rotation.rotate(closedLogPath, newLogPath);
+    });
+    scheduleCompression(rotation);
+}
+
+/*!
+ * Schedules compression of logs in \a rotation set, if enabled. Safe to
+ * call from any thread.
+ *
+ * \sa enableLogCompression
+ */
+void MLog::scheduleCompression(const MLogRotation &rotation)
+{
+    if (m_logCompression.load() == false)
+        return;
+
+    m_worker->post([this, rotation]() {
+        if (m_logCompression.load() == false)
+            return;
+
+        bool done = false;
+        m_worker->runWithPriority(m_compressionPriority.load(), [&]() {
+            done = rotation.compress(m_compressionLevel.load(), [this]() {
+                return m_worker->hasPendingTasks();
+            });
+        });
+        if (done == false) {
+            // Gave way to other tasks, continue after them
+            scheduleCompression(rotation);
+            return;
         }
-    } else if (m_rotationType == MLog::RotationType::DateTime) {
-        const QRegularExpression expr("(" + appName + "-)"
-                      "(\\d\\d\\d\\d-\\d\\d-\\d\\d_\\d\\d-\\d\\d-\\d\\d)"
-                                + m_fileExt);
-        QDateTime oldest = QDateTime::currentDateTime();
-
-        for(const auto &file : qAsConst(files)) {
-            const auto match = expr.match(file);
-            if (match.hasMatch()) {
-                const auto index = QDateTime::fromString(
-                            match.captured(2), m_dateTimeFormat);
-
-                if (index < oldest) {
-                    oldest = index;
-                    lastLog = file;
-                }
-            }
+
+        QMutexLocker locker(&m_mutex);
+        const QString compressedPath = m_previousLogPath + QStringLiteral(".gz");
+        if (QFileInfo::exists(m_previousLogPath) == false
+                && QFileInfo::exists(compressedPath)) {
+            m_previousLogPath = compressedPath;
         }
+    });
+}
+
+/*!
+ * Returns true if log level \a qtLevel is within logger logging level set
+ * in setLogLevel().
+ *
+ * \sa setLogLevel
+ */
+bool MLog::isMessageAllowed(const QtMsgType qtLevel) const
+{
+    switch (qtLevel) {
+    case QtDebugMsg:
+        return isLevelEnabled(DebugLog);
+    case QtInfoMsg:
+        return isLevelEnabled(InfoLog);
+    case QtWarningMsg:
+        return isLevelEnabled(WarningLog);
+    case QtCriticalMsg:
+        return isLevelEnabled(CriticalLog);
+    case QtFatalMsg:
+        return isLevelEnabled(FatalLog);
     }
 
-    QFile::remove(logFilePath + '/' + lastLog);
+    return false;
+}
+
+/*!
+ * Returns the singleton instance of MLog. Synonym to MLog::instance(),
+ * but easier to write.
+ */
+MLog *logger()
+{
+    return MLog::instance();
 }
@@ -24,19 +24,42 @@ SOFTWARE.
 #pragma once
 
 #include <QString>
+#include <QByteArray>
 #include <QMutex>
 #include <QFile>
 #include <QStandardPaths>
 #include <QLoggingCategory>
 #include <QDir>
 #include <QDebug>
+#include <QVector>
+#include <QThread>
+#include <QElapsedTimer>
+
+#include <atomic>
 
 #include "mlogtypes.h"
 #include "mcolorlog.h"
+#include "mlogrecord.h"
 
 Q_DECLARE_LOGGING_CATEGORY(core)
 
 class QMessageLogContext;
+class MLogWriter;
+class MLogWorker;
+class MLogFormatter;
+class MLogCallSites;
+class MLogRotation;
+struct MLogConfig;
+class MLogConfigReaders;
+class MLogConfigRef;
+class MLogSink;
+class MLogConsoleSink;
+class MLogFlightRecorder;
+class MLogStatisticsCounters;
+class MLogStaging;
+struct MLogStatistics;
+struct MLogCallSiteStatistics;
+struct MLogMessage;
 
 class MLog
 {
@@ -60,22 +83,122 @@ public:
      *
      * This is useful when debugging, user can run the application twice and
      * easily compare the logs from both runs.
+     *
+     * Logs can also be rotated while the application is running, once the
+     * current log grows too big or too old. See setLogRotation().
      */
     enum class RotationType{
         Consequent, //!< current -> previous -> previous-1 ...
         DateTime //!< <appName>-<datetime>.log
     };
 
+    /*!
+     * Format of the log file. See setFileFormat().
+     */
+    enum class FileFormat {
+        Text, //!< Messages formatted according to messagePattern()
+        Binary, //!< Compact binary records, decoded later by mlog-decode
+        Json //!< One JSON object per line, including MLogRecord fields
+    };
+
+    /*!
+     * Clock used to timestamp messages. See setClockSource().
+     */
+    enum class ClockSource {
+        System, //!< Precise wall clock
+        Coarse, //!< Coarse wall clock (CLOCK_REALTIME_COARSE), cheaper to read
+        Monotonic //!< Wall clock read once, then advanced by monotonic clock
+    };
+
+    /*!
+     * Precision of message timestamps. See setClockSource().
+     */
+    enum class TimestampPrecision {
+        Milliseconds, //!< Full clock precision
+        Seconds //!< Timestamps are truncated to whole seconds
+    };
+
+    /*!
+     * Decides what happens in asynchronous mode when the message queue is
+     * full. See enableAsyncLogging().
+     */
+    enum class OverflowPolicy {
+        Block, //!< Logging thread waits until the writer makes some space
+        Drop //!< Message is dropped (and counted, see droppedMessageCount())
+    };
+
+    /*!
+     * Decides which messages share a rate limit. See enableRateLimit().
+     */
+    enum class RateLimitScope {
+        CallSite, //!< Every place in code which logs has its own limit
+        Category //!< All messages of a logging category share the limit
+    };
+
+    /*!
+     * Decides when log file output is written out. See setFileFlushPolicy().
+     */
+    enum class FileFlushPolicy {
+        Default, //!< Right away, or when the writer is idle in asynchronous mode
+        Buffered, //!< Only once 64 KiB are pending
+        Periodic //!< At most the given time late, or once given size is pending
+    };
+
+    /*!
+     * Decides when console output is written out. See
+     * setConsoleFlushPolicy().
+     */
+    enum class ConsoleFlushPolicy {
+        Immediate, //!< Every message is written right away
+        LineCount, //!< Written once the given number of lines is pending
+        Interval, //!< Written at most the given number of milliseconds late
+        Severity //!< Warnings and above right away, other messages buffered
+    };
+
     static MLog *instance();
     void enableLogToFile(const QString &appName,
                          const QString &directory = QStandardPaths::writableLocation(
                              QStandardPaths::DocumentsLocation));
     void disableLogToFile();
 
-    void setLogRotation(RotationType type, int maxLogs);
+    void setLogRotation(RotationType type, int maxLogs,
+                        const qint64 maxFileSize = 0, const int maxFileAge = 0);
+
+    void setBackgroundRotation(const bool enabled);
+    bool isBackgroundRotation() const;
+
+    void enableLogCompression(const int level = 6,
+                              const QThread::Priority priority = QThread::LowPriority);
+    void disableLogCompression();
+    bool isLogCompression() const;
+
+    void setFileFormat(const FileFormat format);
+    FileFormat fileFormat() const;
+
+    void setFileFlushPolicy(const FileFlushPolicy policy, const int interval = 1000,
+                            const qint64 size = 0);
+    FileFlushPolicy fileFlushPolicy() const;
+    void setSyncOnCritical(const bool enabled);
+    bool isSyncOnCritical() const;
+    void setFilePreallocation(const qint64 chunkSize);
+    qint64 filePreallocation() const;
+
+    void setMessagePattern(const QString &pattern);
+    QString messagePattern() const;
+
+    void setClockSource(const ClockSource source,
+                        const TimestampPrecision precision = TimestampPrecision::Milliseconds);
+    ClockSource clockSource() const;
+    TimestampPrecision timestampPrecision() const;
+
+    void addSink(MLogSink *sink);
+    void removeSink(MLogSink *sink);
+    QVector<MLogSink *> sinks() const;
 
     void enableLogToConsole();
     void disableLogToConsole();
+    void setConsoleFlushPolicy(const ConsoleFlushPolicy policy, const int threshold = 0);
+    ConsoleFlushPolicy consoleFlushPolicy() const;
 
     QString previousLogPath() const;
     QString currentLogPath() const;
@@ -83,32 +206,176 @@ public:
     void setLogLevel(const LogLevel level);
     LogLevel logLevel() const;
 
+    bool setCategoryLogLevels(const QString &rules);
+    void setCategoryLogLevel(const QString &category, const LogLevel level);
+    void clearCategoryLogLevels();
+    LogLevel categoryLogLevel(const char *category) const;
+
+    void setSampling(const QString &category, const LogLevel level, const int oneIn);
+    void clearSampling();
+
+    /*!
+     * Returns true if messages of \a level pass the level set by
+     * setLogLevel(). This is a single relaxed atomic load. It does not take
+     * per-category levels into account, see setCategoryLogLevels().
+     */
+    static bool isLevelEnabled(const LogLevel level)
+    {
+        return level <= sLogLevel.load(std::memory_order_relaxed);
+    }
+
     void writeRaw(QtMsgType type, const QString &message);
+    void logUtf8(QtMsgType type, const QMessageLogContext &context,
+                 const QByteArray &message);
+
+    void enableRateLimit(const int messagesPerSecond, const int burst = 0,
+                         const RateLimitScope scope = RateLimitScope::CallSite);
+    void disableRateLimit();
+    bool isRateLimit() const;
+    quint64 suppressedMessageCount() const;
+
+    void setCollapseRepeatedMessages(const bool enabled);
+    bool isCollapseRepeatedMessages() const;
+
+    void enableFlightRecorder(const int capacity = 1000, const LogLevel level = DebugLog,
+                              const int maxLineSize = 512);
+    void disableFlightRecorder();
+    bool isFlightRecorder() const;
+    void dumpFlightRecorder();
+
+    void enableAsyncLogging(const int queueSize = 8192,
+                            const OverflowPolicy policy = OverflowPolicy::Block);
+    void disableAsyncLogging();
+    bool isAsyncLogging() const;
+    quint64 droppedMessageCount() const;
+    void flush();
+
+    void enableThreadBuffering(const int size = 16384, const int interval = 100);
+    void disableThreadBuffering();
+    bool isThreadBuffering() const;
+
+    void setStatisticsEnabled(const bool enabled);
+    bool isStatisticsEnabled() const;
+    MLogStatistics statistics() const;
+    void resetStatistics();
+
+    void setCallSiteProfiling(const bool enabled, const int reportSize = 20);
+    bool isCallSiteProfiling() const;
+    QVector<MLogCallSiteStatistics> topCallSites(const int count = 20) const;
 
 private:
     Q_DISABLE_COPY(MLog)
+    friend class MLogWriter;
+    friend class MLogCategoryLevels;
     explicit MLog();
     ~MLog();
     static void messageHandler(QtMsgType type,
                                const QMessageLogContext &context,
                                const QString &message);
-    void write(const QString &message);
+    void handleMessage(QtMsgType type, const QMessageLogContext &context,
+                       const QString &message, const QByteArray &utf8);
+    MLogConfigRef config() const;
+    template <typename Change>
+    void changeConfig(Change change);
+    void scheduleReclaim();
+    void reclaimConfigs();
+    bool needsThreadPointer(const MLogConfig *config) const;
+    qint64 currentTimestamp(const MLogConfig *config) const;
+    bool isRateLimited(const MLogConfig *config, const QMessageLogContext &context,
+                       quint64 &suppressed);
+    void countMessage(const char *category, const QtMsgType type);
+    void profileCallSite(const QMessageLogContext &context, const qsizetype size);
+    void writeCallSiteReport(const int count);
+    void output(const MLogMessage &message);
+    void detachContext(MLogMessage &message);
+    bool collapseRepeated(const MLogMessage &message);
+    void flushRepeated();
+    void outputMessage(const MLogMessage &message);
+    void writeSinks(const MLogMessage &message, const QVector<MLogSink *> &sinks,
+                    const MLogFormatter *formatter, const QByteArray &line);
+    void write(const QByteArray &data, const FileFormat format, const qint64 timestamp);
+    void writeBinary(const MLogMessage &message);
+    void writeJson(const MLogConfig *config, const MLogMessage &message);
+    bool stage(const MLogConfig *config, const MLogMessage &message,
+               const QByteArray &line, const FileFormat format);
+    void writeStaged();
+    void record(MLogFlightRecorder *recorder, const MLogMessage &message);
+    void writeFlightRecorder(MLogFlightRecorder *recorder);
+    void flushFileBufferIfNeeded();
+    void flushFileBuffer();
+    void writePendingOutput();
+    void flushFile(const bool sync);
+    bool openLogFile(const FileFormat format, const bool append);
+    void closeLogFile();
+    void rotateIfNeeded(const qint64 pendingBytes, const qint64 timestamp);
+    void rotateCurrentFile(const qint64 timestamp);
+    void scheduleCompression(const MLogRotation &rotation);
     bool isMessageAllowed(const QtMsgType qtLevel) const;
-    void rotateLogFiles(const QString& appName);
-    QString findPreviousLogPath(const QString &logFileDir, const QString &appName);
-    void removeLastLog(const QString &appName, const QDir &logsDir);
 
-    bool m_logToFile = false;
-    bool m_logToConsole = true;
+    //! Current configuration snapshot, see changeConfig()
+    std::atomic<const MLogConfig *> m_config{nullptr};
+    //! Threads using configuration snapshots, see config()
+    MLogConfigReaders *m_configReaders = nullptr;
+    //! Guarded by m_configMutex
+    bool m_reclaimScheduled = false;
+    QMutex m_configMutex;
     QFile m_logFile;
+    QByteArray m_fileBuffer;
+    //! Started when data is added into empty m_fileBuffer
+    QElapsedTimer m_fileBufferTimer;
+    FileFlushPolicy m_fileFlushPolicy = FileFlushPolicy::Default;
+    int m_fileFlushInterval = 1000;
+    qint64 m_fileFlushSize = 0;
+    std::atomic<bool> m_syncOnCritical{false};
+    qint64 m_preallocationChunk = 0;
+    //! Size of current log file on disk
+    qint64 m_fileEnd = 0;
+    //! End of space preallocated for current log file
+    qint64 m_preallocatedEnd = 0;
     QString m_previousLogPath;
     QString m_currentLogPath;
-    QMutex m_mutex;
-    LogLevel m_logLevel = DebugLog;
+    mutable QMutex m_mutex;
     RotationType m_rotationType = RotationType::Consequent;
     int m_maxLogs = 2;
-    const QString m_dateTimeFormat = QStringLiteral("yyyy-MM-dd_HH-mm-ss");
-    const QString m_fileExt = QStringLiteral(".log");
+    qint64 m_maxFileSize = 0;
+    int m_maxFileAge = 0;
+    bool m_backgroundRotation = false;
+    std::atomic<bool> m_logCompression{false};
+    std::atomic<int> m_compressionLevel{6};
+    std::atomic<QThread::Priority> m_compressionPriority{QThread::LowPriority};
+    QString m_appName;
+    QString m_logDirectory;
+    //! Bytes of messages written into current log file
+    qint64 m_fileSize = 0;
+    //! Time at which current log file was opened, in ms since epoch
+    qint64 m_fileOpenedAt = 0;
+    quint64 m_rotationCount = 0;
+    MLogWorker *m_worker = nullptr;
+    //! Created once, guarded by m_configMutex
+    std::atomic<MLogWriter *> m_writer{nullptr};
+    //! Shared formatter of the message pattern, see MLogFormatter::shared()
+    std::atomic<const MLogFormatter *> m_formatter{nullptr};
+    MLogConsoleSink *m_console = nullptr;
+    std::atomic<quint64> m_suppressedCount{0};
+    MLogStatisticsCounters *m_statistics = nullptr;
+    std::atomic<quint64> m_bytesWritten{0};
+    //! Last message and how many times it was repeated since, see
+    //! setCollapseRepeatedMessages()
+    QMutex m_repeatMutex;
+    MLogMessage *m_lastMessage = nullptr;
+    quint64 m_repeatCount = 0;
+    //! Format of the currently open log file
+    std::atomic<FileFormat> m_openFileFormat{FileFormat::Text};
+    //! Incremented whenever a log file is opened, see MLogCallSite
+    quint64 m_fileGeneration = 0;
+    MLogCallSites *m_callSites = nullptr;
+    //! Per-thread buffers of log file lines, see enableThreadBuffering()
+    MLogStaging *m_staging = nullptr;
+    std::atomic<bool> m_stagingScheduled{false};
+    //! Set while writeStaged() runs, guarded by m_mutex
+    bool m_writingStaged = false;
+
+    static std::atomic<LogLevel> sLogLevel;
 };
 
 MLog *logger();
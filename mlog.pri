@@ -1,15 +1,42 @@
 QT *= core
-CONFIG *= c++11
+CONFIG *= c++17
 
 # Warning! QStringBuilder can crash your app! See last point here:
 # https://www.kdab.com/uncovering-32-qt-best-practices-compile-time-clazy/
 # !!!
 DEFINES *= QT_USE_QSTRINGBUILDER QT_MESSAGELOGCONTEXT
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+# mDebug(), mCDebug() etc. are compiled out in release too. To remove other
+# levels, set MLOG_COMPILED_LOG_LEVEL before including this file
+# (0 NoLog ... 5 Debug, see mcolorlog.h)
+isEmpty(MLOG_COMPILED_LOG_LEVEL) {
+    CONFIG(release, debug|release):MLOG_COMPILED_LOG_LEVEL = 4
+    else:MLOG_COMPILED_LOG_LEVEL = 5
+}
+DEFINES *= MLOG_COMPILED_LOG_LEVEL=$$MLOG_COMPILED_LOG_LEVEL
+lessThan(MLOG_COMPILED_LOG_LEVEL, 4):DEFINES *= QT_NO_INFO_OUTPUT
+lessThan(MLOG_COMPILED_LOG_LEVEL, 3):DEFINES *= QT_NO_WARNING_OUTPUT
+# Set MLOG_SANITIZE_THREAD = 1 before including this file to build with
+# ThreadSanitizer
+!isEmpty(MLOG_SANITIZE_THREAD):CONFIG *= sanitizer sanitize_thread
 
 INCLUDEPATH *= $$PWD
 
-HEADERS *= $$PWD/mlog.h $$PWD/mlogtypes.h
-SOURCES *= $$PWD/mlog.cpp $$PWD/mlogtypes.cpp
+HEADERS *= $$PWD/mlog.h $$PWD/mlogtypes.h \
+    $$PWD/mlogmessage.h $$PWD/mlogqueue.h $$PWD/mlogwriter.h \
+    $$PWD/mlogutf8.h $$PWD/mlogformatter.h $$PWD/mlogclock.h \
+    $$PWD/mlogcallsite.h $$PWD/mlogbinary.h $$PWD/mlogworker.h \
+    $$PWD/mlogrotation.h $$PWD/mloggzip.h $$PWD/mlogcategorylevels.h \
+    $$PWD/mlogconfig.h $$PWD/mlogrecord.h $$PWD/mlogjson.h \
+    $$PWD/mlogsink.h $$PWD/mlogstorage.h $$PWD/mlogflightrecorder.h \
+    $$PWD/mlogstatistics.h $$PWD/mlogformat.h $$PWD/mlogstaging.h
+SOURCES *= $$PWD/mlog.cpp $$PWD/mlogtypes.cpp \
+    $$PWD/mlogwriter.cpp $$PWD/mlogutf8.cpp \
+    $$PWD/mlogformatter.cpp $$PWD/mlogclock.cpp \
+    $$PWD/mlogcallsite.cpp $$PWD/mlogbinary.cpp $$PWD/mlogworker.cpp \
+    $$PWD/mlogrotation.cpp $$PWD/mloggzip.cpp $$PWD/mlogcategorylevels.cpp \
+    $$PWD/mlogconfig.cpp $$PWD/mlogrecord.cpp $$PWD/mlogjson.cpp \
+    $$PWD/mlogsink.cpp $$PWD/mlogstorage.cpp $$PWD/mlogflightrecorder.cpp \
+    $$PWD/mlogstatistics.cpp $$PWD/mlogformat.cpp $$PWD/mlogstaging.cpp
 
 OTHER_FILES *= $$PWD/README.md $$PWD/AUTHORS.md $$PWD/mlog.doxyfile
@@ -0,0 +1,393 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogbinary.h"
+#include "mlogcallsite.h"
+#include "mlogutf8.h"
+#include "mlogjson.h"
+
+#include <QIODevice>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+void appendVarint(QByteArray &out, quint64 value)
+{
+    char buffer[10];
+    int size = 0;
+    do {
+        char byte = char(value & 0x7f);
+        value >>= 7;
+        if (value)
+            byte = char(byte | 0x80);
+        buffer[size++] = byte;
+    } while (value);
+    out.append(buffer, size);
+}
+
+void appendInt64(QByteArray &out, const qint64 value)
+{
+    char buffer[8];
+    qToLittleEndian(value, buffer);
+    out.append(buffer, 8);
+}
+
+void appendString(QByteArray &out, const char *string)
+{
+    if (string == nullptr) {
+        appendVarint(out, 0);
+        return;
+    }
+
+    const std::size_t size = std::strlen(string);
+    appendVarint(out, size + 1);
+    out.append(string, int(size));
+}
+
+void finishString(QByteArray &out, const int lengthPos)
+{
+    // Strings are encoded first, length is known only afterwards. Strings are
+    // short, so length usually fits in 1 byte and we only need to fix it up
+    // for longer ones
+    const quint64 length = quint64(out.size() - lengthPos - 1) + 1;
+    if (length < 0x80) {
+        out[lengthPos] = char(length);
+    } else {
+        QByteArray prefix;
+        appendVarint(prefix, length);
+        out.replace(lengthPos, 1, prefix);
+    }
+}
+
+void appendString(QByteArray &out, const QString &string)
+{
+    const int lengthPos = out.size();
+    out.append(char(0));
+    mlog::appendUtf8(out, string);
+    finishString(out, lengthPos);
+}
+
+void appendText(QByteArray &out, const MLogMessage &message)
+{
+    const int lengthPos = out.size();
+    out.append(char(0));
+    mlog::appendMessageText(out, message);
+    // Fields of structured messages are stored as part of message text
+    mlog::appendFields(out, message.fields);
+    finishString(out, lengthPos);
+}
+
+}
+
+/*!
+ * \class MLogBinary
+ * \internal
+ * \brief Binary log encoder
+ *
+ * Binary records contain only the raw data of a message. Everything else
+ * (rendering the timestamp, cleaning up function name, applying the message
+ * pattern) is deferred to the mlog-decode tool.
+ */
+
+const char MLogBinary::magic[9] = "MLOGBIN1";
+
+/*!
+ * Appends file header to \a out. \a pattern is used by the decoder to turn
+ * records back into text. \a appName and \a pid are stored for %{appname}
+ * and %{pid}.
+ */
+void MLogBinary::appendHeader(QByteArray &out, const QString &pattern,
+                              const QString &appName, const qint64 pid)
+{
+    out.append(magic, 8);
+    appendString(out, pattern);
+    appendString(out, appName);
+    appendVarint(out, quint64(pid));
+}
+
+/*!
+ * Appends definition of call \a site to \a out.
+ */
+void MLogBinary::appendCallSite(QByteArray &out, const MLogCallSite &site)
+{
+    out.append(char(CallSiteRecord));
+    appendVarint(out, site.id);
+    appendVarint(out, quint32(site.line));
+    appendString(out, site.file);
+    appendString(out, site.function);
+    appendString(out, site.category);
+}
+
+/*!
+ * Appends \a message, logged from call site \a callSiteId, to \a out.
+ */
+void MLogBinary::appendMessage(QByteArray &out, const quint32 callSiteId,
+                               const MLogMessage &message)
+{
+    out.append(char(MessageRecord));
+    appendVarint(out, callSiteId);
+    out.append(char(message.type));
+    appendInt64(out, message.timestamp);
+    appendVarint(out, quint64(message.threadId));
+    appendVarint(out, quint64(message.threadPointer));
+    appendText(out, message);
+}
+
+/*!
+ * Appends MLog::writeRaw() \a message to \a out.
+ */
+void MLogBinary::appendRaw(QByteArray &out, const MLogMessage &message)
+{
+    out.append(char(RawRecord));
+    out.append(char(message.type));
+    appendInt64(out, message.timestamp);
+    appendText(out, message);
+}
+
+/*!
+ * \class MLogBinaryReader
+ * \internal
+ * \brief Binary log decoder
+ */
+
+/*!
+ * Creates reader of binary log from \a device, which must be open.
+ */
+MLogBinaryReader::MLogBinaryReader(QIODevice *device)
+    : m_device(device)
+{
+}
+
+/*!
+ * Reads file header. Must be called before next(). Returns false if the
+ * device does not contain a binary log.
+ */
+bool MLogBinaryReader::readHeader()
+{
+    const QByteArray fileMagic = m_device->read(8);
+    if (fileMagic != QByteArray(MLogBinary::magic, 8)) {
+        m_errorString = QStringLiteral("Not a binary MLog file");
+        return false;
+    }
+
+    QByteArray pattern;
+    QByteArray appName;
+    quint64 pid = 0;
+    bool isNull = false;
+    if (!readString(pattern, isNull) || !readString(appName, isNull)
+            || !readVarint(pid)) {
+        m_errorString = QStringLiteral("Truncated file header");
+        return false;
+    }
+
+    m_pattern = QString::fromUtf8(pattern);
+    m_appName = QString::fromUtf8(appName);
+    m_pid = qint64(pid);
+    return true;
+}
+
+/*!
+ * Reads next message into \a message. Call site definitions are consumed
+ * internally. Context strings in \a message stay valid as long as the reader
+ * exists.
+ */
+MLogBinaryReader::Result MLogBinaryReader::next(MLogMessage &message)
+{
+    for (;;) {
+        quint8 recordType = 0;
+        if (!readByte(recordType))
+            return Result::End;
+
+        if (recordType == MLogBinary::CallSiteRecord) {
+            if (!readCallSite())
+                return fail(QStringLiteral("Truncated call site record"));
+            continue;
+        }
+
+        quint8 type = 0;
+        qint64 timestamp = 0;
+        bool isNull = false;
+        QByteArray text;
+        if (recordType == MLogBinary::RawRecord) {
+            if (!readByte(type) || !readInt64(timestamp)
+                    || !readString(text, isNull)) {
+                return fail(QStringLiteral("Truncated raw record"));
+            }
+
+            message = MLogMessage();
+            message.type = QtMsgType(type);
+            message.timestamp = timestamp;
+            message.raw = true;
+            message.message = QString::fromUtf8(text);
+            return Result::Raw;
+        }
+
+        if (recordType != MLogBinary::MessageRecord)
+            return fail(QStringLiteral("Unknown record type %1").arg(int(recordType)));
+
+        quint64 callSiteId = 0;
+        quint64 threadId = 0;
+        quint64 threadPointer = 0;
+        if (!readVarint(callSiteId) || !readByte(type) || !readInt64(timestamp)
+                || !readVarint(threadId) || !readVarint(threadPointer)
+                || !readString(text, isNull)) {
+            return fail(QStringLiteral("Truncated message record"));
+        }
+
+        message = MLogMessage();
+        message.type = QtMsgType(type);
+        message.timestamp = timestamp;
+        message.threadId = qint64(threadId);
+        message.threadPointer = quintptr(threadPointer);
+        message.message = QString::fromUtf8(text);
+
+        if (callSiteId != 0) {
+            const auto it = m_callSites.constFind(quint32(callSiteId));
+            if (it == m_callSites.constEnd())
+                return fail(QStringLiteral("Unknown call site %1").arg(callSiteId));
+
+            message.line = it->line;
+            message.file = it->hasFile ? it->file.constData() : nullptr;
+            message.function = it->hasFunction ? it->function.constData() : nullptr;
+            message.category = it->hasCategory ? it->category.constData() : nullptr;
+        }
+        return Result::Message;
+    }
+}
+
+/*!
+ * Returns message pattern stored in file header.
+ */
+QString MLogBinaryReader::pattern() const
+{
+    return m_pattern;
+}
+
+/*!
+ * Returns name of the application which wrote the file.
+ */
+QString MLogBinaryReader::appName() const
+{
+    return m_appName;
+}
+
+/*!
+ * Returns process ID of the application which wrote the file.
+ */
+qint64 MLogBinaryReader::pid() const
+{
+    return m_pid;
+}
+
+/*!
+ * Returns description of the last error.
+ */
+QString MLogBinaryReader::errorString() const
+{
+    return m_errorString;
+}
+
+bool MLogBinaryReader::readByte(quint8 &value)
+{
+    char c = 0;
+    if (!m_device->getChar(&c))
+        return false;
+    value = quint8(c);
+    return true;
+}
+
+bool MLogBinaryReader::readVarint(quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        quint8 byte = 0;
+        if (!readByte(byte))
+            return false;
+
+        value |= quint64(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool MLogBinaryReader::readInt64(qint64 &value)
+{
+    char buffer[8];
+    if (m_device->read(buffer, 8) != 8)
+        return false;
+    value = qFromLittleEndian<qint64>(buffer);
+    return true;
+}
+
+bool MLogBinaryReader::readString(QByteArray &value, bool &isNull)
+{
+    quint64 length = 0;
+    if (!readVarint(length))
+        return false;
+
+    isNull = (length == 0);
+    if (isNull) {
+        value.clear();
+        return true;
+    }
+
+    --length;
+    if (length > quint64(std::numeric_limits<int>::max()))
+        return false;
+
+    value = m_device->read(qint64(length));
+    return quint64(value.size()) == length;
+}
+
+bool MLogBinaryReader::readCallSite()
+{
+    quint64 id = 0;
+    quint64 line = 0;
+    bool fileNull = false;
+    bool functionNull = false;
+    bool categoryNull = false;
+    CallSite site;
+    if (!readVarint(id) || !readVarint(line)
+            || !readString(site.file, fileNull)
+            || !readString(site.function, functionNull)
+            || !readString(site.category, categoryNull)) {
+        return false;
+    }
+
+    site.hasFile = !fileNull;
+    site.hasFunction = !functionNull;
+    site.hasCategory = !categoryNull;
+    site.line = int(line);
+    m_callSites.insert(quint32(id), site);
+    return true;
+}
+
+MLogBinaryReader::Result MLogBinaryReader::fail(const QString &error)
+{
+    m_errorString = error;
+    return Result::Error;
+}
@@ -0,0 +1,126 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include "mlogmessage.h"
+
+class QIODevice;
+struct MLogCallSite;
+
+/*!
+ * \internal
+ * Encoder for binary log files (see MLog::FileFormat::Binary).
+ *
+ * File layout (all integers are little endian, "varint" is LEB128):
+ * \list
+ * \li header: 8 byte magic "MLOGBIN1", message pattern, application name
+ *     (strings) and process ID (varint)
+ * \li any number of records, each starting with a record type byte:
+ *     \list
+ *     \li CallSiteRecord: id (varint), line (varint), file, function and
+ *         category (strings). Written once per call site per file
+ *     \li MessageRecord: call site id (varint, 0 = unknown), message type
+ *         (byte), timestamp in ms since epoch (8 bytes), thread ID (varint),
+ *         QThread pointer (varint), message text (string, MLogRecord fields
+ *         are appended to it as " key=value" pairs)
+ *     \li RawRecord: message type (byte), timestamp (8 bytes), text (string)
+ *     \endlist
+ * \endlist
+ *
+ * Strings are stored as varint (length + 1) followed by UTF-8 bytes, length 0
+ * means null.
+ */
+class MLogBinary
+{
+public:
+    enum RecordType : quint8 {
+        CallSiteRecord = 1,
+        MessageRecord = 2,
+        RawRecord = 3
+    };
+
+    static const char magic[9];
+
+    static void appendHeader(QByteArray &out, const QString &pattern,
+                             const QString &appName, const qint64 pid);
+    static void appendCallSite(QByteArray &out, const MLogCallSite &site);
+    static void appendMessage(QByteArray &out, const quint32 callSiteId,
+                              const MLogMessage &message);
+    static void appendRaw(QByteArray &out, const MLogMessage &message);
+};
+
+/*!
+ * \internal
+ * Streaming decoder of binary log files. Reads one record at a time, memory
+ * use only depends on the number of call sites.
+ */
+class MLogBinaryReader
+{
+public:
+    enum class Result {
+        Message, //!< Formatted message was read
+        Raw, //!< MLog::writeRaw() text was read
+        End, //!< End of file
+        Error //!< File is corrupt, see errorString()
+    };
+
+    explicit MLogBinaryReader(QIODevice *device);
+
+    bool readHeader();
+    Result next(MLogMessage &message);
+
+    QString pattern() const;
+    QString appName() const;
+    qint64 pid() const;
+    QString errorString() const;
+
+private:
+    struct CallSite {
+        int line = 0;
+        QByteArray file;
+        QByteArray function;
+        QByteArray category;
+        bool hasFile = false;
+        bool hasFunction = false;
+        bool hasCategory = false;
+    };
+
+    bool readByte(quint8 &value);
+    bool readVarint(quint64 &value);
+    bool readInt64(qint64 &value);
+    bool readString(QByteArray &value, bool &isNull);
+    bool readCallSite();
+    Result fail(const QString &error);
+
+    QIODevice *m_device = nullptr;
+    QHash<quint32, CallSite> m_callSites;
+    QString m_pattern;
+    QString m_appName;
+    qint64 m_pid = 0;
+    QString m_errorString;
+};
@@ -0,0 +1,199 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogcallsite.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const quint64 hashMultiplier = Q_UINT64_C(0x9e3779b97f4a7c15);
+
+//! Mixes \a string into \a hash, null is different from an empty string
+quint64 hashString(quint64 hash, const char *string)
+{
+    if (string == nullptr)
+        return (hash ^ 1) * hashMultiplier;
+
+    // FNV-1a
+    for (const char *it = string; *it; ++it)
+        hash = (hash ^ uchar(*it)) * Q_UINT64_C(0x100000001b3);
+    return (hash ^ 2) * hashMultiplier;
+}
+
+quint32 hashCallSite(const char *file, const int line, const char *function,
+                     const char *category)
+{
+    quint64 hash = Q_UINT64_C(0xcbf29ce484222325);
+    hash = hashString(hash, file);
+    hash = hashString(hash, function);
+    hash = hashString(hash, category);
+    hash = (hash ^ quint64(quint32(line))) * hashMultiplier;
+    return quint32(hash >> 32);
+}
+
+bool isSameString(const char *left, const char *right)
+{
+    if (left == right)
+        return true;
+    return left && right && std::strcmp(left, right) == 0;
+}
+
+bool isSameCallSite(const MLogCallSite *site, const char *file, const int line,
+                    const char *function, const char *category)
+{
+    return site->line == line && isSameString(site->file, file)
+            && isSameString(site->function, function)
+            && isSameString(site->category, category);
+}
+
+//! Copies \a string into \a data, returns pointer to the copy
+const char *copyString(QByteArray &data, const char *string)
+{
+    if (string == nullptr)
+        return nullptr;
+    data = QByteArray(string);
+    return data.constData();
+}
+
+}
+
+/*!
+ * Takes a token from the bucket at \a now. Tokens are added every
+ * \a interval nanoseconds, the bucket holds \a tolerance / \a interval + 1
+ * of them. Returns false if the bucket is empty.
+ *
+ * This is the generic cell rate algorithm: instead of counting tokens, the
+ * bucket only remembers when it is going to be empty, so the whole state is
+ * a single atomic updated with compare-and-swap.
+ */
+bool MLogTokenBucket::acquire(const qint64 now, const qint64 interval,
+                              const qint64 tolerance)
+{
+    qint64 expected = nextTime.load(std::memory_order_relaxed);
+    for (;;) {
+        const qint64 start = qMax(expected, now);
+        if (start - now > tolerance)
+            return false;
+        if (nextTime.compare_exchange_weak(expected, start + interval,
+                                           std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+/*!
+ * Returns current time of the steady clock, in nanoseconds.
+ */
+qint64 MLogTokenBucket::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ * \class MLogCallSites
+ * \internal
+ * \brief Lock-free registry of call sites
+ *
+ * Call sites are kept in a fixed size open addressing hash table keyed by
+ * QMessageLogContext strings (file, function, category) and line number.
+ * Lookups hash the strings and compare them with the call site found, which
+ * takes a few atomic loads and no locking. Only inserting a new call site
+ * takes a mutex, which happens once per call site.
+ *
+ * Strings usually point to static data, but QML and other code which builds
+ * QMessageLogger at runtime frees them right after logging. Call sites keep
+ * copies of their own, so they can be read at any time later.
+ *
+ * Once the registry holds MaxSites call sites (or a probe sequence gets too
+ * long), new call sites are no longer registered and lookups of unknown call
+ * sites fail fast, without locking.
+ */
+
+MLogCallSites::MLogCallSites()
+    : m_table(new std::atomic<MLogCallSite *>[Capacity]())
+{
+}
+
+MLogCallSites::~MLogCallSites()
+{
+    qDeleteAll(m_sites);
+}
+
+/*!
+ * Returns call site described by \a file, \a line, \a function and
+ * \a category, registering it on first use. Safe to call from any thread.
+ *
+ * Returns nullptr if the registry is full.
+ */
+MLogCallSite *MLogCallSites::intern(const char *file, const int line,
+                                    const char *function, const char *category)
+{
+    const quint32 mask = Capacity - 1;
+    const quint32 hash = hashCallSite(file, line, function, category);
+
+    for (quint32 probe = 0; probe < quint32(MaxProbes); ++probe) {
+        std::atomic<MLogCallSite *> &slot = m_table[(hash + probe) & mask];
+        MLogCallSite *site = slot.load(std::memory_order_acquire);
+        if (site == nullptr) {
+            if (m_full.load(std::memory_order_relaxed))
+                return nullptr;
+
+            QMutexLocker locker(&m_mutex);
+            // Someone might have filled this slot while we were waiting
+            site = slot.load(std::memory_order_acquire);
+            if (site == nullptr) {
+                if (m_sites.size() >= MaxSites) {
+                    m_full.store(true, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                site = new MLogCallSite;
+                site->id = quint32(m_sites.size() + 1);
+                site->file = copyString(site->fileData, file);
+                site->line = line;
+                site->function = copyString(site->functionData, function);
+                site->category = copyString(site->categoryData, category);
+                m_sites.append(site);
+                slot.store(site, std::memory_order_release);
+                return site;
+            }
+        }
+
+        if (isSameCallSite(site, file, line, function, category))
+            return site;
+    }
+
+    return nullptr;
+}
+
+/*!
+ * Returns all call sites registered so far.
+ */
+QVector<MLogCallSite *> MLogCallSites::sites() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sites;
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+/*!
+ * \internal
+ * Lock-free token bucket, used to rate limit messages. See
+ * MLog::enableRateLimit().
+ */
+struct MLogTokenBucket
+{
+    //! Time (in steady clock nanoseconds) at which the bucket will be full
+    //! again, minus one interval
+    std::atomic<qint64> nextTime{0};
+    //! Messages rejected since the last one which was let through
+    std::atomic<quint64> suppressed{0};
+
+    bool acquire(const qint64 now, const qint64 interval, const qint64 tolerance);
+    static qint64 now();
+};
+
+/*!
+ * \internal
+ * A single place in code which logs messages, identified by the strings and
+ * line number in its QMessageLogContext.
+ */
+struct MLogCallSite
+{
+    quint32 id = 0;
+    int line = 0;
+    //! Point into the copies below (or are null), so they stay valid after
+    //! the logging code frees its own strings
+    const char *file = nullptr;
+    const char *function = nullptr;
+    const char *category = nullptr;
+    QByteArray fileData;
+    QByteArray functionData;
+    QByteArray categoryData;
+    //! Binary log file in which this call site was last defined. Guarded by
+    //! MLog's file mutex
+    quint64 fileGeneration = 0;
+    MLogTokenBucket rateLimit;
+    //! Messages logged in the category, while statistics are enabled. Only
+    //! counted in call sites without file, line and function
+    std::atomic<quint64> categoryCount{0};
+    //! Messages logged and UTF-8 bytes of their text, while call site
+    //! profiling is enabled
+    std::atomic<quint64> messageCount{0};
+    std::atomic<quint64> messageSize{0};
+};
+
+/*!
+ * \internal
+ * Interns call sites, so that each one is described only once and can later
+ * be found by pointer hashing, without locking.
+ */
+class MLogCallSites
+{
+public:
+    MLogCallSites();
+    ~MLogCallSites();
+
+    MLogCallSite *intern(const char *file, const int line,
+                         const char *function, const char *category);
+    QVector<MLogCallSite *> sites() const;
+
+private:
+    Q_DISABLE_COPY(MLogCallSites)
+
+    static const int Capacity = 1 << 14;
+    //! Registry is considered full above this many call sites, so that
+    //! probe sequences stay short
+    static const int MaxSites = Capacity / 4 * 3;
+    static const int MaxProbes = 64;
+
+    std::unique_ptr<std::atomic<MLogCallSite *>[]> m_table;
+    QVector<MLogCallSite *> m_sites;
+    std::atomic<bool> m_full{false};
+    mutable QMutex m_mutex;
+};
@@ -0,0 +1,434 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogcategorylevels.h"
+
+#include <QRegularExpression>
+
+#include <QHash>
+
+#include <cstring>
+
+namespace {
+
+struct State
+{
+    QMutex mutex;
+    QVector<MLogCategoryLevels::Rule> rules;
+    QVector<MLogCategoryLevels::Sampling> sampling;
+    QLoggingCategory::CategoryFilter previousFilter = nullptr;
+    bool installed = false;
+    //! Categories are enabled at least up to this level, see isEnabled()
+    MLog::LogLevel recordingLevel = MLog::NoLog;
+    //! Incremented whenever levels change
+    std::atomic<quint64> generation{0};
+};
+
+// Categories can be created (and filtered) at any point of static
+// initialization, so state is created on first use
+State &state()
+{
+    static State sState;
+    return sState;
+}
+
+bool parseLevel(const QString &name, MLog::LogLevel &level)
+{
+    static const struct {
+        const char *name;
+        MLog::LogLevel level;
+    } levels[] = {
+        { "none", MLog::NoLog },
+        { "off", MLog::NoLog },
+        { "fatal", MLog::FatalLog },
+        { "critical", MLog::CriticalLog },
+        { "warning", MLog::WarningLog },
+        { "info", MLog::InfoLog },
+        { "debug", MLog::DebugLog }
+    };
+
+    for (const auto &entry : levels) {
+        if (name.compare(QLatin1String(entry.name), Qt::CaseInsensitive) == 0) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+/*!
+ * \class MLogCategoryLevels
+ * \internal
+ * \brief Per-category log levels
+ *
+ * MLog installs filter() as Qt's category filter, chained after the filter
+ * which was installed before (Qt's own one, applying QT_LOGGING_RULES and
+ * QLoggingCategory::setFilterRules()). For each category, the filter finds
+ * the last matching rule (or falls back to MLog::logLevel()) and disables
+ * message types above that level. It never enables anything that Qt rules
+ * disabled.
+ *
+ * The result is stored in QLoggingCategory itself, so deciding whether to log
+ * a message costs the same single atomic load as plain qCDebug(). Rules are
+ * only matched when a category is created or when levels change.
+ */
+
+/*!
+ * Returns true if this rule applies to \a category.
+ */
+bool MLogCategoryLevels::Rule::matches(const char *category) const
+{
+    if (category == nullptr)
+        return false;
+
+    const std::size_t size = std::strlen(category);
+    const std::size_t patternSize = std::size_t(pattern.size());
+    if (anyPrefix && anySuffix)
+        return std::strstr(category, pattern.constData()) != nullptr;
+    if (size < patternSize)
+        return false;
+    if (anyPrefix)
+        return std::memcmp(category + size - patternSize, pattern.constData(), patternSize) == 0;
+    if (anySuffix)
+        return std::memcmp(category, pattern.constData(), patternSize) == 0;
+    return size == patternSize
+            && std::memcmp(category, pattern.constData(), patternSize) == 0;
+}
+
+/*!
+ * Parses \a rules in form "net.*=debug, db=warning" and appends them to
+ * \a result. Rules are separated by commas, semicolons or new lines. Returns
+ * false if any rule is invalid, valid ones are appended anyway.
+ */
+bool MLogCategoryLevels::parse(const QString &rules, QVector<Rule> &result)
+{
+    bool ok = true;
+    const QRegularExpression separator(QStringLiteral("[,;\\n]"));
+    for (const QString &entry : rules.split(separator)) {
+        const QString trimmed = entry.trimmed();
+        if (trimmed.isEmpty())
+            continue;
+
+        const int equals = trimmed.indexOf(QLatin1Char('='));
+        MLog::LogLevel level = MLog::DebugLog;
+        if (equals <= 0 || parseLevel(trimmed.mid(equals + 1).trimmed(), level) == false) {
+            ok = false;
+            continue;
+        }
+
+        result.append(rule(trimmed.left(equals).trimmed(), level));
+    }
+    return ok;
+}
+
+/*!
+ * Returns rule setting \a level for categories matching \a pattern. Pattern
+ * is either a category name, or a category name with '*' at the beginning
+ * and/or at the end, just like in QLoggingCategory::setFilterRules().
+ */
+MLogCategoryLevels::Rule MLogCategoryLevels::rule(const QString &pattern,
+                                                  const MLog::LogLevel level)
+{
+    Rule result;
+    QString name = pattern;
+    if (name.startsWith(QLatin1Char('*'))) {
+        result.anyPrefix = true;
+        name.remove(0, 1);
+    }
+    if (name.endsWith(QLatin1Char('*'))) {
+        result.anySuffix = true;
+        name.chop(1);
+    }
+    result.pattern = name.toUtf8();
+    result.level = level;
+    return result;
+}
+
+/*!
+ * Installs the category filter. Called once, by MLog's constructor.
+ */
+void MLogCategoryLevels::install()
+{
+    State &current = state();
+    const QLoggingCategory::CategoryFilter previous = QLoggingCategory::installFilter(&filter);
+    {
+        QMutexLocker locker(&current.mutex);
+        if (previous != &filter)
+            current.previousFilter = previous;
+        current.installed = true;
+    }
+
+    // Categories were filtered before previous filter was known
+    update();
+}
+
+/*!
+ * Puts back the filter which was installed before install().
+ */
+void MLogCategoryLevels::uninstall()
+{
+    State &current = state();
+    QLoggingCategory::CategoryFilter previous = nullptr;
+    {
+        QMutexLocker locker(&current.mutex);
+        if (current.installed == false)
+            return;
+        current.installed = false;
+        previous = current.previousFilter;
+    }
+    QLoggingCategory::installFilter(previous);
+}
+
+/*!
+ * Applies current levels to all existing categories. Must not be called with
+ * the mutex locked, Qt calls filter() from here.
+ */
+void MLogCategoryLevels::update()
+{
+    state().generation.fetch_add(1, std::memory_order_release);
+    {
+        QMutexLocker locker(&state().mutex);
+        if (state().installed == false)
+            return;
+    }
+
+    // Qt runs the filter over all categories whenever one is installed. If
+    // somebody installed their filter after ours, put it back on top
+    const QLoggingCategory::CategoryFilter top = QLoggingCategory::installFilter(&filter);
+    if (top != &filter)
+        QLoggingCategory::installFilter(top);
+}
+
+/*!
+ * Replaces all rules with \a rules and updates existing categories.
+ */
+void MLogCategoryLevels::setRules(const QVector<Rule> &rules)
+{
+    {
+        QMutexLocker locker(&state().mutex);
+        state().rules = rules;
+    }
+    update();
+}
+
+/*!
+ * Adds \a rule after existing ones (so it takes precedence over them) and
+ * updates existing categories.
+ */
+void MLogCategoryLevels::addRule(const Rule &rule)
+{
+    {
+        QMutexLocker locker(&state().mutex);
+        state().rules.append(rule);
+    }
+    update();
+}
+
+/*!
+ * Returns log level for \a category: level of the last rule matching it, or
+ * MLog::logLevel() if there is none.
+ */
+MLog::LogLevel MLogCategoryLevels::level(const char *category)
+{
+    QMutexLocker locker(&state().mutex);
+    const QVector<Rule> &rules = state().rules;
+    for (auto it = rules.crbegin(); it != rules.crend(); ++it) {
+        if (it->matches(category))
+            return it->level;
+    }
+    return MLog::sLogLevel.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Returns the most verbose log level at which messages of \a type are
+ * logged.
+ */
+MLog::LogLevel MLogCategoryLevels::messageLevel(const QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return MLog::DebugLog;
+    case QtInfoMsg:
+        return MLog::InfoLog;
+    case QtWarningMsg:
+        return MLog::WarningLog;
+    case QtCriticalMsg:
+        return MLog::CriticalLog;
+    case QtFatalMsg:
+        return MLog::FatalLog;
+    }
+    return MLog::DebugLog;
+}
+
+/*!
+ * Returns true if messages of \a type pass log level of \a category. Levels
+ * are cached per thread until they change, so this does not lock in the
+ * common case.
+ *
+ * Only needed while categories are enabled above their levels, see
+ * setRecordingLevel(). Otherwise Qt does not even call the message handler
+ * for such messages.
+ */
+bool MLogCategoryLevels::isEnabled(const char *category, const QtMsgType type)
+{
+    struct Cached {
+        quint64 generation;
+        MLog::LogLevel level;
+    };
+    static thread_local QHash<const char *, Cached> cache;
+
+    const quint64 generation = state().generation.load(std::memory_order_acquire);
+    auto it = cache.find(category);
+    if (it == cache.end() || it->generation != generation)
+        it = cache.insert(category, { generation, level(category) });
+
+    return messageLevel(type) <= it->level;
+}
+
+/*!
+ * Adds \a sampling rule after existing ones (so it takes precedence over
+ * them).
+ *
+ * \sa MLog::setSampling
+ */
+void MLogCategoryLevels::addSampling(const Sampling &sampling)
+{
+    {
+        QMutexLocker locker(&state().mutex);
+        state().sampling.append(sampling);
+    }
+    state().generation.fetch_add(1, std::memory_order_release);
+}
+
+/*!
+ * Removes all sampling rules.
+ */
+void MLogCategoryLevels::clearSampling()
+{
+    {
+        QMutexLocker locker(&state().mutex);
+        state().sampling.clear();
+    }
+    state().generation.fetch_add(1, std::memory_order_release);
+}
+
+/*!
+ * Returns N if messages of \a type in \a category are sampled 1 in N times,
+ * or 1 if all of them are logged. Rates are cached per thread until rules
+ * change, just like in isEnabled().
+ */
+int MLogCategoryLevels::samplingRate(const char *category, const QtMsgType type)
+{
+    struct Cached {
+        quint64 generation;
+        //! Rate for each MLog::LogLevel
+        int rates[MLog::DebugLog + 1];
+    };
+    static thread_local QHash<const char *, Cached> cache;
+
+    const quint64 generation = state().generation.load(std::memory_order_acquire);
+    auto it = cache.find(category);
+    if (it == cache.end() || it->generation != generation) {
+        Cached cached;
+        cached.generation = generation;
+        QMutexLocker locker(&state().mutex);
+        const QVector<Sampling> &sampling = state().sampling;
+        for (int level = MLog::NoLog; level <= MLog::DebugLog; ++level) {
+            cached.rates[level] = 1;
+            for (auto rule = sampling.crbegin(); rule != sampling.crend(); ++rule) {
+                if (level >= rule->rule.level && rule->rule.matches(category)) {
+                    cached.rates[level] = qMax(rule->oneIn, 1);
+                    break;
+                }
+            }
+        }
+        it = cache.insert(category, cached);
+    }
+
+    return it->rates[messageLevel(type)];
+}
+
+/*!
+ * Returns true once in \a oneIn calls on average. Uses a per-thread
+ * xorshift generator, so it never locks and costs a few instructions.
+ */
+bool MLogCategoryLevels::sample(const int oneIn)
+{
+    static thread_local quint64 sState = 0;
+    if (sState == 0) {
+        // Different sequence in every thread
+        sState = quint64(quintptr(&sState)) * Q_UINT64_C(0x9e3779b97f4a7c15) | 1;
+    }
+
+    sState ^= sState << 13;
+    sState ^= sState >> 7;
+    sState ^= sState << 17;
+    return sState % quint64(oneIn) == 0;
+}
+
+/*!
+ * Keeps categories enabled up to \a level, even if their log level is lower,
+ * and updates existing categories. Used by MLog's flight recorder, which
+ * needs to see messages that are not logged.
+ *
+ * \sa MLog::enableFlightRecorder
+ */
+void MLogCategoryLevels::setRecordingLevel(const MLog::LogLevel level)
+{
+    {
+        QMutexLocker locker(&state().mutex);
+        state().recordingLevel = level;
+    }
+    update();
+}
+
+/*!
+ * Qt category filter. Lets the previous filter decide first, then disables
+ * message types above the level of \a category (or above recording level, if
+ * it is higher).
+ */
+void MLogCategoryLevels::filter(QLoggingCategory *category)
+{
+    QLoggingCategory::CategoryFilter previous = nullptr;
+    MLog::LogLevel recordingLevel = MLog::NoLog;
+    {
+        QMutexLocker locker(&state().mutex);
+        previous = state().previousFilter;
+        recordingLevel = state().recordingLevel;
+    }
+    if (previous)
+        previous(category);
+
+    const MLog::LogLevel level = qMax(MLogCategoryLevels::level(category->categoryName()),
+                                      recordingLevel);
+    if (level < MLog::DebugLog)
+        category->setEnabled(QtDebugMsg, false);
+    if (level < MLog::InfoLog)
+        category->setEnabled(QtInfoMsg, false);
+    if (level < MLog::WarningLog)
+        category->setEnabled(QtWarningMsg, false);
+    if (level < MLog::CriticalLog)
+        category->setEnabled(QtCriticalMsg, false);
+}
@@ -0,0 +1,82 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include "mlog.h"
+
+#include <QMutex>
+#include <QVector>
+
+/*!
+ * \internal
+ * Per-category log levels (see MLog::setCategoryLogLevels()).
+ *
+ * Levels are applied through Qt's category filter: whenever a
+ * QLoggingCategory is created, or the rules change, the threshold for that
+ * category is computed once and folded into its enabled flags. Checking
+ * whether a message is enabled is then just QLoggingCategory::isEnabled().
+ */
+class MLogCategoryLevels
+{
+public:
+    struct Rule
+    {
+        QByteArray pattern;
+        //! Pattern started with '*', matches the end of category name
+        bool anyPrefix = false;
+        //! Pattern ended with '*', matches the beginning of category name
+        bool anySuffix = false;
+        MLog::LogLevel level = MLog::DebugLog;
+
+        bool matches(const char *category) const;
+    };
+
+    //! Messages of categories matching \c rule, at \c rule.level or more
+    //! verbose, are logged 1 in \c oneIn times
+    struct Sampling
+    {
+        Rule rule;
+        int oneIn = 1;
+    };
+
+    static bool parse(const QString &rules, QVector<Rule> &result);
+    static Rule rule(const QString &pattern, const MLog::LogLevel level);
+
+    static void install();
+    static void uninstall();
+    static void update();
+    static void setRules(const QVector<Rule> &rules);
+    static void addRule(const Rule &rule);
+    static MLog::LogLevel level(const char *category);
+    static MLog::LogLevel messageLevel(const QtMsgType type);
+    static bool isEnabled(const char *category, const QtMsgType type);
+    static void setRecordingLevel(const MLog::LogLevel level);
+    static void addSampling(const Sampling &sampling);
+    static void clearSampling();
+    static int samplingRate(const char *category, const QtMsgType type);
+    static bool sample(const int oneIn);
+
+private:
+    static void filter(QLoggingCategory *category);
+};
@@ -0,0 +1,95 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogclock.h"
+
+#include <QDateTime>
+
+#include <chrono>
+
+#if defined(Q_OS_LINUX)
+#include <time.h>
+#endif
+
+/*!
+ * \class MLogClock
+ * \internal
+ * \brief Clock sources for message timestamps
+ *
+ * All functions return milliseconds since epoch.
+ */
+
+/*!
+ * Reads clock selected by \a source.
+ */
+qint64 MLogClock::now(const MLog::ClockSource source)
+{
+    switch (source) {
+    case MLog::ClockSource::Coarse:
+        return coarseTime();
+    case MLog::ClockSource::Monotonic:
+        return monotonicTime();
+    case MLog::ClockSource::System:
+        break;
+    }
+
+    return systemTime();
+}
+
+/*!
+ * Precise wall clock time.
+ */
+qint64 MLogClock::systemTime()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+/*!
+ * Wall clock time read from CLOCK_REALTIME_COARSE. It is updated once per
+ * kernel tick (usually every 1-4 ms), but reading it is considerably cheaper
+ * than reading the precise clock. Falls back to systemTime() on platforms
+ * without a coarse clock.
+ */
+qint64 MLogClock::coarseTime()
+{
+#if defined(Q_OS_LINUX) && defined(CLOCK_REALTIME_COARSE)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0)
+        return qint64(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+#endif
+    return systemTime();
+}
+
+/*!
+ * Wall clock time computed from a monotonic clock: wall time is read once, on
+ * first use, and afterwards only the (cheap) monotonic offset is added.
+ * Timestamps never go backwards, but they do not follow wall clock
+ * adjustments made while the application is running.
+ */
+qint64 MLogClock::monotonicTime()
+{
+    using namespace std::chrono;
+    static const qint64 baseTime = systemTime();
+    static const steady_clock::time_point baseTick = steady_clock::now();
+    return baseTime + duration_cast<milliseconds>(steady_clock::now() - baseTick).count();
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogconfig.h"
+
+/*!
+ * \class MLogConfigReaders
+ * \internal
+ * \brief Deferred deleting of configuration snapshots
+ *
+ * A thread which logs registers in the current generation before it loads a
+ * snapshot, and unregisters when done with it. Reclaiming takes everything
+ * retired so far, switches new readers to the other generation and later
+ * deletes what it took once the previous generation has no readers left. A
+ * reader which loaded a retired snapshot has registered before it was
+ * retired, so it is always waited for.
+ *
+ * Before generations are switched, the other generation has to be empty as
+ * well: a reader can read the generation, get preempted and register in it
+ * only after the previous switch.
+ *
+ * retire() and reclaim() are not thread safe, MLog calls them with its
+ * configuration mutex locked.
+ */
+
+/*!
+ * Deletes everything which is still retired.
+ */
+MLogConfigReaders::~MLogConfigReaders()
+{
+    reclaimAll();
+}
+
+/*!
+ * Schedules \a destroy to be called once no thread can use the object it
+ * deletes anymore.
+ */
+void MLogConfigReaders::retire(std::function<void()> destroy)
+{
+    m_retired.append(std::move(destroy));
+}
+
+/*!
+ * Deletes retired objects which no reader can use anymore and moves on to
+ * the next generation. Returns true if there is anything left to delete, in
+ * which case reclaim() has to be called again later.
+ */
+bool MLogConfigReaders::reclaim()
+{
+    if (m_draining.isEmpty() == false) {
+        if (readerCount(m_drainingGeneration) > 0)
+            return true;
+        for (const std::function<void()> &destroy : qAsConst(m_draining))
+            destroy();
+        m_draining.clear();
+    }
+
+    if (m_retired.isEmpty())
+        return false;
+
+    // Readers which registered late in the other generation have to finish
+    // before new readers are sent there
+    const int generation = m_generation.load(std::memory_order_relaxed);
+    if (readerCount(generation ^ 1) > 0)
+        return true;
+
+    m_draining.swap(m_retired);
+    m_drainingGeneration = generation;
+    m_generation.store(generation ^ 1, std::memory_order_seq_cst);
+    return true;
+}
+
+/*!
+ * Deletes all retired objects right away. Only safe when no other thread
+ * reads configuration anymore.
+ */
+void MLogConfigReaders::reclaimAll()
+{
+    for (const std::function<void()> &destroy : qAsConst(m_draining))
+        destroy();
+    for (const std::function<void()> &destroy : qAsConst(m_retired))
+        destroy();
+    m_draining.clear();
+    m_retired.clear();
+}
+
+/*!
+ * Returns number of threads registered in \a generation.
+ */
+qint64 MLogConfigReaders::readerCount(const int generation) const
+{
+    qint64 result = 0;
+    for (const Shard &shard : m_shards)
+        result += shard.readers[generation].load(std::memory_order_seq_cst);
+    return result;
+}
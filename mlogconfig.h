@@ -0,0 +1,181 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include "mlog.h"
+
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+/*!
+ * \internal
+ * Runtime configuration of MLog, read by every logged message.
+ *
+ * Snapshots are immutable. MLog publishes a new one whenever configuration
+ * changes (see MLog::changeConfig()), so threads which log read all settings
+ * with a single atomic load, never lock and never see half of a change.
+ * Snapshots are only read through MLogConfigRef, which keeps them alive.
+ */
+struct MLogConfig
+{
+    bool logToFile = false;
+    bool logToConsole = true;
+    bool asyncLogging = false;
+    MLog::FileFormat fileFormat = MLog::FileFormat::Text;
+    MLog::ClockSource clockSource = MLog::ClockSource::System;
+    MLog::TimestampPrecision timestampPrecision = MLog::TimestampPrecision::Milliseconds;
+    //! Sinks attached with MLog::addSink()
+    QVector<MLogSink *> sinks;
+    //! See MLog::enableFlightRecorder()
+    MLogFlightRecorder *flightRecorder = nullptr;
+    MLog::LogLevel flightRecorderLevel = MLog::NoLog;
+    //! Nanoseconds between two messages let through by rate limit, 0 if
+    //! disabled. See MLog::enableRateLimit()
+    qint64 rateLimitInterval = 0;
+    //! How far ahead of the rate limit messages can get (burst)
+    qint64 rateLimitTolerance = 0;
+    MLog::RateLimitScope rateLimitScope = MLog::RateLimitScope::CallSite;
+    bool collapseRepeated = false;
+    //! True if there are any sampling rules, see MLog::setSampling()
+    bool sampling = false;
+    bool statistics = false;
+    //! See MLog::setCallSiteProfiling()
+    bool profiling = false;
+    int profilingReportSize = 20;
+    //! Size of per-thread log file buffers, 0 if disabled. See
+    //! MLog::enableThreadBuffering()
+    int threadBufferSize = 0;
+    int threadBufferInterval = 100;
+};
+
+/*!
+ * \internal
+ * Counts threads which read configuration snapshots, so that replaced
+ * snapshots (and sinks or flight recorders which only they refer to) are
+ * deleted once no thread can use them anymore.
+ *
+ * Readers are counted in two generations, in sharded counters, so reading
+ * costs two uncontended atomic increments. Reclaiming starts a new
+ * generation for new readers and waits until the previous one drains.
+ * Readers never wait, and a reader which blocks (on a slow console, a file
+ * sync or a preempted thread) only delays reclaiming.
+ */
+class MLogConfigReaders
+{
+public:
+    ~MLogConfigReaders();
+
+    int lock();
+    void unlock(const int generation);
+
+    void retire(std::function<void()> destroy);
+    bool reclaim();
+    void reclaimAll();
+
+private:
+    static const int ShardCount = 16;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<qint64> readers[2] = {};
+    };
+
+    static int currentShard();
+    qint64 readerCount(const int generation) const;
+
+    std::atomic<int> m_generation{0};
+    Shard m_shards[ShardCount];
+    //! Retired since the last generation was started
+    QVector<std::function<void()>> m_retired;
+    //! Waiting for readers of m_drainingGeneration
+    QVector<std::function<void()>> m_draining;
+    int m_drainingGeneration = 0;
+};
+
+/*!
+ * \internal
+ * Returns shard of the calling thread.
+ */
+inline int MLogConfigReaders::currentShard()
+{
+    static std::atomic<int> sNextShard{0};
+    static thread_local const int sShard
+            = sNextShard.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+    return sShard;
+}
+
+/*!
+ * \internal
+ * Registers the calling thread as a reader, returns generation which has to
+ * be passed to unlock(). Has to be called before the snapshot is loaded.
+ */
+inline int MLogConfigReaders::lock()
+{
+    const int generation = m_generation.load(std::memory_order_seq_cst);
+    m_shards[currentShard()].readers[generation].fetch_add(1, std::memory_order_seq_cst);
+    return generation;
+}
+
+/*!
+ * \internal
+ * Unregisters reader of \a generation, after it is done with the snapshot.
+ */
+inline void MLogConfigReaders::unlock(const int generation)
+{
+    m_shards[currentShard()].readers[generation].fetch_sub(1, std::memory_order_release);
+}
+
+/*!
+ * \internal
+ * Configuration snapshot which stays valid as long as this object exists.
+ * Returned by MLog::config(); keep it on the stack for as long as the
+ * snapshot is used, never store the pointer.
+ */
+class MLogConfigRef
+{
+public:
+    MLogConfigRef(MLogConfigReaders *readers, const std::atomic<const MLogConfig *> &config)
+        : m_readers(readers), m_generation(readers->lock()),
+          m_config(config.load(std::memory_order_seq_cst))
+    {
+    }
+
+    ~MLogConfigRef()
+    {
+        m_readers->unlock(m_generation);
+    }
+
+    const MLogConfig *get() const { return m_config; }
+    const MLogConfig *operator->() const { return m_config; }
+    const MLogConfig &operator*() const { return *m_config; }
+
+private:
+    Q_DISABLE_COPY(MLogConfigRef)
+
+    MLogConfigReaders *m_readers;
+    int m_generation;
+    const MLogConfig *m_config;
+};
@@ -0,0 +1,309 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogflightrecorder.h"
+
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<MLogFlightRecorder *> sCrashRecorder{nullptr};
+std::atomic<int> sCrashFd{2};
+//! Set once the recorder was written out because of qFatal()
+std::atomic<bool> sDumped{false};
+
+#ifdef Q_OS_UNIX
+const int sCrashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+const int sCrashSignalCount = int(sizeof(sCrashSignals) / sizeof(sCrashSignals[0]));
+struct sigaction sPreviousActions[sCrashSignalCount];
+bool sCrashHandlerInstalled = false;
+//! Alternate signal stack of the thread which installed the crash handler
+char *sAlternateStack = nullptr;
+
+//! write() which can be used in a signal handler
+void writeAll(const int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written <= 0)
+            return;
+        data += written;
+        size -= std::size_t(written);
+    }
+}
+#endif
+
+}
+
+/*!
+ * \class MLogFlightRecorder
+ * \internal
+ * \brief Ring of recent messages, written out on crash
+ */
+
+/*!
+ * Preallocates the ring for \a capacity lines of at most \a lineSize bytes.
+ */
+MLogFlightRecorder::MLogFlightRecorder(const int capacity, const int lineSize)
+    : m_capacity(qMax(capacity, 1)), m_lineSize(qMax(lineSize, 16)),
+      m_slots(new Slot[std::size_t(m_capacity)]),
+      m_data(new char[std::size_t(m_capacity) * std::size_t(m_lineSize)])
+{
+}
+
+MLogFlightRecorder::~MLogFlightRecorder()
+{
+    MLogFlightRecorder *self = this;
+    sCrashRecorder.compare_exchange_strong(self, nullptr);
+}
+
+/*!
+ * Returns maximum number of lines kept in the ring.
+ */
+int MLogFlightRecorder::capacity() const
+{
+    return m_capacity;
+}
+
+/*!
+ * Returns true if the ring was created for \a capacity lines of at most
+ * \a lineSize bytes.
+ */
+bool MLogFlightRecorder::hasSize(const int capacity, const int lineSize) const
+{
+    return m_capacity == qMax(capacity, 1) && m_lineSize == qMax(lineSize, 16);
+}
+
+/*!
+ * Copies \a line into the ring, replacing the oldest one. Trailing newline is
+ * dropped, lines longer than the slot size are truncated (on a UTF-8
+ * character boundary). Safe to call from any thread.
+ */
+void MLogFlightRecorder::record(const QByteArray &line)
+{
+    const quint64 index = m_next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[index % quint64(m_capacity)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int size = line.size();
+    if (size > 0 && line.at(size - 1) == '\n')
+        --size;
+    if (size > m_lineSize) {
+        size = m_lineSize;
+        // Do not cut a multi-byte character in half
+        while (size > 0 && (uchar(line.at(size)) & 0xC0) == 0x80)
+            --size;
+    }
+
+    std::memcpy(data(index), line.constData(), std::size_t(size));
+    slot.size.store(size, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+/*!
+ * Returns recorded lines, oldest first, without trailing newlines. Lines
+ * being recorded at the same time are skipped.
+ */
+QVector<QByteArray> MLogFlightRecorder::lines() const
+{
+    QVector<QByteArray> result;
+    const quint64 next = m_next.load(std::memory_order_acquire);
+    for (quint64 index = first(); index < next; ++index) {
+        const Slot &slot = m_slots[index % quint64(m_capacity)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+            continue;
+
+        QByteArray line(data(index), slot.size.load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Slot was overwritten while it was copied
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1)
+            continue;
+        result.append(line);
+    }
+    return result;
+}
+
+/*!
+ * Writes recorded lines into file descriptor \a fd, between header() and
+ * footer(). Only uses async-signal-safe functions, so it can be called from
+ * a signal handler. Does nothing on platforms without POSIX write().
+ */
+void MLogFlightRecorder::writeTo(const int fd) const
+{
+#ifdef Q_OS_UNIX
+    writeAll(fd, header(), std::strlen(header()));
+    const quint64 next = m_next.load(std::memory_order_acquire);
+    for (quint64 index = first(); index < next; ++index) {
+        const Slot &slot = m_slots[index % quint64(m_capacity)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+            continue;
+
+        writeAll(fd, data(index), std::size_t(slot.size.load(std::memory_order_relaxed)));
+        writeAll(fd, "\n", 1);
+    }
+    writeAll(fd, footer(), std::strlen(footer()));
+#else
+    Q_UNUSED(fd)
+#endif
+}
+
+/*!
+ * Installs handlers of fatal signals (SIGSEGV, SIGBUS, SIGILL, SIGFPE and
+ * SIGABRT) which write the crash recorder into the crash output and then
+ * let the previously installed handler (or the default action) run. Only
+ * available on Unix.
+ *
+ * Handlers run on an alternate signal stack, so that a stack overflow (whose
+ * SIGSEGV leaves no stack to run a handler on) is recorded too. Alternate
+ * stacks are per thread: the calling thread gets one, unless it has one
+ * already. Other threads need to set up their own with sigaltstack().
+ *
+ * \sa setCrashRecorder, setCrashOutput
+ */
+void MLogFlightRecorder::installCrashHandler()
+{
+#ifdef Q_OS_UNIX
+    if (sCrashHandlerInstalled)
+        return;
+
+    stack_t stack;
+    if (sigaltstack(nullptr, &stack) == 0 && (stack.ss_flags & SS_DISABLE)) {
+        const std::size_t size = qMax(std::size_t(SIGSTKSZ), std::size_t(64 * 1024));
+        if (sAlternateStack == nullptr)
+            sAlternateStack = new char[size];
+        stack.ss_sp = sAlternateStack;
+        stack.ss_size = size;
+        stack.ss_flags = 0;
+        sigaltstack(&stack, nullptr);
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &crashHandler;
+    action.sa_flags = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (int i = 0; i < sCrashSignalCount; ++i)
+        sigaction(sCrashSignals[i], &action, &sPreviousActions[i]);
+    sCrashHandlerInstalled = true;
+#endif
+}
+
+/*!
+ * Puts back signal handlers which were installed before
+ * installCrashHandler().
+ */
+void MLogFlightRecorder::uninstallCrashHandler()
+{
+#ifdef Q_OS_UNIX
+    if (sCrashHandlerInstalled == false)
+        return;
+
+    for (int i = 0; i < sCrashSignalCount; ++i)
+        sigaction(sCrashSignals[i], &sPreviousActions[i], nullptr);
+    sCrashHandlerInstalled = false;
+#endif
+}
+
+/*!
+ * Sets \a recorder written out by the crash handler, or nullptr to write
+ * nothing.
+ */
+void MLogFlightRecorder::setCrashRecorder(MLogFlightRecorder *recorder)
+{
+    sCrashRecorder.store(recorder, std::memory_order_release);
+}
+
+/*!
+ * Sets file descriptor \a fd the crash handler writes into. Default is 2
+ * (stderr).
+ */
+void MLogFlightRecorder::setCrashOutput(const int fd)
+{
+    sCrashFd.store(fd, std::memory_order_relaxed);
+}
+
+/*!
+ * Tells the crash handler that the recorder was already written out (by
+ * qFatal(), which aborts right after).
+ */
+void MLogFlightRecorder::markDumped()
+{
+    sDumped.store(true, std::memory_order_relaxed);
+}
+
+/*!
+ * Returns the line written in front of recorded lines.
+ */
+const char *MLogFlightRecorder::header()
+{
+    return "--- Flight recorder: most recent messages ---\n";
+}
+
+/*!
+ * Returns the line written after recorded lines.
+ */
+const char *MLogFlightRecorder::footer()
+{
+    return "--- End of flight recorder ---\n";
+}
+
+/*!
+ * Returns index of the oldest line still kept in the ring.
+ */
+quint64 MLogFlightRecorder::first() const
+{
+    const quint64 next = m_next.load(std::memory_order_acquire);
+    return next > quint64(m_capacity) ? next - quint64(m_capacity) : 0;
+}
+
+/*!
+ * Returns storage of line with \a index.
+ */
+char *MLogFlightRecorder::data(const quint64 index) const
+{
+    return m_data.get() + std::size_t(index % quint64(m_capacity)) * std::size_t(m_lineSize);
+}
+
+void MLogFlightRecorder::crashHandler(int signal)
+{
+#ifdef Q_OS_UNIX
+    const MLogFlightRecorder *recorder = sCrashRecorder.load(std::memory_order_acquire);
+    if (recorder && sDumped.exchange(true) == false)
+        recorder->writeTo(sCrashFd.load(std::memory_order_relaxed));
+
+    // Let the previous handler (or the default action) finish the job
+    for (int i = 0; i < sCrashSignalCount; ++i) {
+        if (sCrashSignals[i] == signal)
+            sigaction(signal, &sPreviousActions[i], nullptr);
+    }
+    raise(signal);
+#else
+    Q_UNUSED(signal)
+#endif
+}
@@ -0,0 +1,83 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+/*!
+ * \internal
+ * Fixed-size ring of recently formatted messages, see
+ * MLog::enableFlightRecorder().
+ *
+ * All memory is allocated up front. Recording a line is lock-free: a slot is
+ * claimed with a single atomic increment and the line is copied into it
+ * (truncated to the slot size). Reading is lock-free as well, slots which are
+ * being overwritten are skipped, so the ring can be dumped from a signal
+ * handler.
+ */
+class MLogFlightRecorder
+{
+public:
+    MLogFlightRecorder(const int capacity, const int lineSize);
+    ~MLogFlightRecorder();
+
+    int capacity() const;
+    bool hasSize(const int capacity, const int lineSize) const;
+    void record(const QByteArray &line);
+    QVector<QByteArray> lines() const;
+    void writeTo(const int fd) const;
+
+    static void installCrashHandler();
+    static void uninstallCrashHandler();
+    static void setCrashRecorder(MLogFlightRecorder *recorder);
+    static void setCrashOutput(const int fd);
+    static void markDumped();
+
+    static const char *header();
+    static const char *footer();
+
+private:
+    Q_DISABLE_COPY(MLogFlightRecorder)
+
+    struct Slot
+    {
+        //! Index of the recorded line plus 1, or 0 while the slot is written
+        std::atomic<quint64> sequence{0};
+        std::atomic<int> size{0};
+    };
+
+    quint64 first() const;
+    char *data(const quint64 index) const;
+    static void crashHandler(int signal);
+
+    const int m_capacity;
+    const int m_lineSize;
+    std::unique_ptr<Slot[]> m_slots;
+    std::unique_ptr<char[]> m_data;
+    std::atomic<quint64> m_next{0};
+};
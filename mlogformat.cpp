@@ -0,0 +1,227 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogformat.h"
+#include "mlogutf8.h"
+#include "mlog.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*!
+ * \internal
+ * Appends \a value to \a out as \c true or \c false.
+ */
+void mlog::detail::appendBool(QByteArray &out, const bool value)
+{
+    if (value)
+        out.append("true", 4);
+    else
+        out.append("false", 5);
+}
+
+/*!
+ * \internal
+ * Appends character \a value to \a out.
+ */
+void mlog::detail::appendChar(QByteArray &out, const char value)
+{
+    out.append(value);
+}
+
+/*!
+ * \internal
+ * Appends decimal representation of \a value to \a out.
+ */
+void mlog::detail::appendSigned(QByteArray &out, const qint64 value)
+{
+    mlog::appendNumber(out, value);
+}
+
+/*!
+ * \internal
+ * Appends decimal representation of \a value to \a out.
+ */
+void mlog::detail::appendUnsigned(QByteArray &out, quint64 value)
+{
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *pos = end;
+    do {
+        *--pos = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    out.append(pos, int(end - pos));
+}
+
+/*!
+ * \internal
+ * Appends \a value to \a out, with the fewest digits which still read back
+ * as the same number (of type float if \a single is true).
+ */
+void mlog::detail::appendFloatingPoint(QByteArray &out, const double value, const bool single)
+{
+    char buffer[32];
+    int size = 0;
+    for (int precision = single ? 6 : 15; precision <= 17; ++precision) {
+        size = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        const double parsed = std::strtod(buffer, nullptr);
+        if (single ? float(parsed) == float(value) : parsed == value)
+            break;
+    }
+
+    // Qt applications run with system locale, which might use a decimal comma
+    for (int i = 0; i < size; ++i) {
+        if (buffer[i] == ',')
+            buffer[i] = '.';
+    }
+    out.append(buffer, size);
+}
+
+/*!
+ * \internal
+ * Appends null-terminated, UTF-8 encoded \a text to \a out. Null pointer is
+ * written as \c (null).
+ */
+void mlog::detail::appendText(QByteArray &out, const char *text)
+{
+    if (text == nullptr)
+        out.append("(null)", 6);
+    else
+        out.append(text, int(std::strlen(text)));
+}
+
+/*!
+ * \internal
+ * Appends \a size bytes of UTF-8 encoded \a text to \a out.
+ */
+void mlog::detail::appendText(QByteArray &out, const char *text, const qsizetype size)
+{
+    out.append(text, int(size));
+}
+
+/*!
+ * \internal
+ * Appends \a string to \a out, encoded as UTF-8.
+ */
+void mlog::detail::appendString(QByteArray &out, const QString &string)
+{
+    mlog::appendUtf8(out, string);
+}
+
+/*!
+ * \internal
+ * Appends \a string to \a out, encoded as UTF-8.
+ */
+void mlog::detail::appendLatin1String(QByteArray &out, const QLatin1String &string)
+{
+    mlog::appendLatin1(out, string.data(), int(string.size()));
+}
+
+/*!
+ * \internal
+ * Appends \a pointer to \a out as a hexadecimal number, like QDebug.
+ */
+void mlog::detail::appendPointer(QByteArray &out, const void *pointer)
+{
+    static const char digits[] = "0123456789abcdef";
+    char buffer[2 + 2 * sizeof(quintptr)];
+    char *end = buffer + sizeof(buffer);
+    char *pos = end;
+    quintptr value = quintptr(pointer);
+    do {
+        *--pos = digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+    *--pos = 'x';
+    *--pos = '0';
+    out.append(pos, int(end - pos));
+}
+
+/*!
+ * \internal
+ * Appends \a text, produced by QDebug, to \a out. QDebug separates items
+ * with spaces, including after the last one, which is dropped here.
+ */
+void mlog::detail::appendDebugText(QByteArray &out, QString &text)
+{
+    if (text.endsWith(QLatin1Char(' ')))
+        text.chop(1);
+    mlog::appendUtf8(out, text);
+}
+
+/*!
+ * \internal
+ * Formats \a format of \a size characters with \a count \a arguments and logs
+ * the result as message of \a type in \a category.
+ *
+ * Message is built in a thread-local buffer, which keeps its capacity between
+ * messages.
+ */
+void mlog::detail::logFormatted(const QtMsgType type, const QLoggingCategory &category,
+                                const char *format, const int size,
+                                const Argument *arguments, const int count)
+{
+    static thread_local QByteArray message;
+    if (message.capacity() == 0)
+        message.reserve(1024);
+    message.resize(0);
+
+    int next = 0;
+    int start = 0;
+    for (int i = 0; i < size; ++i) {
+        const char c = format[i];
+        if (c != '{' && c != '}')
+            continue;
+
+        message.append(format + start, i - start);
+        const char following = i + 1 < size ? format[i + 1] : '\0';
+        if (c == '{' && following == '}') {
+            if (next < count) {
+                arguments[next].append(message, arguments[next].value);
+                ++next;
+            } else {
+                message.append("{?}", 3);
+            }
+            ++i;
+        } else if (following == c) {
+            // Escaped brace
+            message.append(c);
+            ++i;
+        } else {
+            // Unmatched brace, written as it is
+            message.append(c);
+        }
+        start = i + 1;
+    }
+    message.append(format + start, size - start);
+
+    for (; next < count; ++next) {
+        message.append(' ');
+        arguments[next].append(message, arguments[next].value);
+    }
+
+    const QMessageLogContext context(nullptr, 0, nullptr, category.categoryName());
+    MLog::instance()->logUtf8(type, context, message);
+}
@@ -0,0 +1,337 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDebug>
+#include <QLatin1String>
+#include <QLoggingCategory>
+#include <QString>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "mcolorlog.h"
+#include "mlogtypes.h"
+
+#if defined(__cpp_consteval)
+//! Defined when format strings are checked at compile time without MLOG_FORMAT()
+#define MLOG_CONSTEVAL_FORMAT 1
+#define MLOG_FORMAT_CONSTRUCTOR consteval
+#else
+#define MLOG_FORMAT_CONSTRUCTOR constexpr
+#endif
+
+/*!
+ * Type-safe formatted logging, without QDebug and QString:
+ * \code
+ * mlog::info(netLogger, "Request {} done in {} ms", id, elapsed);
+ * \endcode
+ *
+ * Every \c {} in the format string is replaced with the next argument
+ * (\c {{ and \c }} stand for literal braces). Arguments are formatted
+ * straight into a thread-local UTF-8 buffer, which is handed to MLog. Messages
+ * go through the same level, category, sampling and rate limit filters as
+ * qCDebug() and friends, and the category is checked before anything is
+ * formatted, so disabled messages cost one call to QLoggingCategory::isEnabled().
+ *
+ * Supported arguments are: \c bool, characters, integers, enums, floating
+ * point numbers, \c const \c char*, QString, QLatin1String, QByteArray,
+ * std::string, std::string_view, mlog::utf8() and pointers. Byte strings are
+ * expected to be UTF-8 and are copied as they are. Other types are formatted
+ * with their QDebug stream operator.
+ *
+ * Number of placeholders has to match number of arguments. In C++20 this is
+ * checked at compile time. With older standards wrap the format string in
+ * MLOG_FORMAT() to get the same check, otherwise missing arguments are written
+ * as \c {?} and extra ones are appended at the end of the message.
+ *
+ * Messages have no file, line and function information.
+ */
+namespace mlog {
+
+namespace detail {
+
+/*!
+ * \internal
+ * Returns number of \c {} placeholders in \a format of \a size characters,
+ * or -1 if it has a brace which is neither a placeholder nor escaped.
+ */
+constexpr int placeholderCount(const char *format, const std::size_t size)
+{
+    int count = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        const char next = i + 1 < size ? format[i + 1] : '\0';
+        if (format[i] == '{') {
+            if (next == '}')
+                ++count;
+            else if (next != '{')
+                return -1;
+            ++i;
+        } else if (format[i] == '}') {
+            if (next != '}')
+                return -1;
+            ++i;
+        }
+    }
+    return count;
+}
+
+template <std::size_t Size>
+constexpr int placeholderCount(const char (&format)[Size])
+{
+    return placeholderCount(format, Size - 1);
+}
+
+/*!
+ * \internal
+ * Deliberately not constexpr: a call from a consteval constructor fails
+ * compilation, with this name in the error message.
+ */
+inline void formatPlaceholdersDoNotMatchArguments() {}
+
+}
+
+/*!
+ * Format string checked at compile time in any C++ standard, created by
+ * MLOG_FORMAT().
+ */
+template <int Placeholders>
+struct CheckedFormat
+{
+    const char *text;
+    int size;
+};
+
+//! Checks placeholders of \a format string literal at compile time, see mlog::info()
+#define MLOG_FORMAT(format) \
+    mlog::CheckedFormat<mlog::detail::placeholderCount(format)>{ format, int(sizeof(format)) - 1 }
+
+/*!
+ * Format string for given number of \a Arguments. Created implicitly from a
+ * string literal or MLOG_FORMAT().
+ */
+template <std::size_t Arguments>
+class FormatString
+{
+public:
+    template <std::size_t Size>
+    MLOG_FORMAT_CONSTRUCTOR FormatString(const char (&format)[Size])
+        : m_text(format), m_size(int(Size - 1))
+    {
+#if defined(MLOG_CONSTEVAL_FORMAT)
+        if (detail::placeholderCount(format, Size - 1) != int(Arguments))
+            detail::formatPlaceholdersDoNotMatchArguments();
+#endif
+    }
+
+    template <int Placeholders>
+    constexpr FormatString(const CheckedFormat<Placeholders> format)
+        : m_text(format.text), m_size(format.size)
+    {
+        static_assert(Placeholders >= 0, "mlog: unmatched brace in format string");
+        static_assert(Placeholders == int(Arguments),
+                      "mlog: number of {} placeholders does not match number of arguments");
+    }
+
+    constexpr const char *text() const { return m_text; }
+    constexpr int size() const { return m_size; }
+
+private:
+    const char *m_text;
+    int m_size;
+};
+
+namespace detail {
+
+/*!
+ * \internal
+ * Type-erased format argument, so that formatting itself is not a template.
+ */
+struct Argument
+{
+    const void *value;
+    void (*append)(QByteArray &out, const void *value);
+};
+
+void appendBool(QByteArray &out, const bool value);
+void appendChar(QByteArray &out, const char value);
+void appendSigned(QByteArray &out, const qint64 value);
+void appendUnsigned(QByteArray &out, const quint64 value);
+void appendFloatingPoint(QByteArray &out, const double value, const bool single);
+void appendText(QByteArray &out, const char *text);
+void appendText(QByteArray &out, const char *text, const qsizetype size);
+void appendString(QByteArray &out, const QString &string);
+void appendLatin1String(QByteArray &out, const QLatin1String &string);
+void appendPointer(QByteArray &out, const void *pointer);
+void appendDebugText(QByteArray &out, QString &text);
+
+template <typename T, typename = void>
+struct IsDebugStreamable : std::false_type {};
+
+template <typename T>
+struct IsDebugStreamable<T, decltype(void(std::declval<QDebug &>() << std::declval<const T &>()))>
+    : std::true_type {};
+
+/*!
+ * \internal
+ * Appends \a value to \a out, as UTF-8.
+ */
+template <typename T>
+void appendValue(QByteArray &out, const T &value)
+{
+    using Type = typename std::decay<T>::type;
+    if constexpr (std::is_same<Type, bool>::value) {
+        appendBool(out, value);
+    } else if constexpr (std::is_same<Type, char>::value) {
+        appendChar(out, value);
+    } else if constexpr (std::is_integral<Type>::value && std::is_signed<Type>::value) {
+        appendSigned(out, qint64(value));
+    } else if constexpr (std::is_integral<Type>::value) {
+        appendUnsigned(out, quint64(value));
+    } else if constexpr (std::is_enum<Type>::value) {
+        appendValue(out, static_cast<typename std::underlying_type<Type>::type>(value));
+    } else if constexpr (std::is_floating_point<Type>::value) {
+        appendFloatingPoint(out, double(value), std::is_same<Type, float>::value);
+    } else if constexpr (std::is_same<Type, const char *>::value
+                         || std::is_same<Type, char *>::value) {
+        appendText(out, value);
+    } else if constexpr (std::is_same<Type, QString>::value) {
+        appendString(out, value);
+    } else if constexpr (std::is_same<Type, QLatin1String>::value) {
+        appendLatin1String(out, value);
+    } else if constexpr (std::is_same<Type, QByteArray>::value) {
+        appendText(out, value.constData(), value.size());
+    } else if constexpr (std::is_same<Type, std::string>::value
+                         || std::is_same<Type, std::string_view>::value) {
+        appendText(out, value.data(), qsizetype(value.size()));
+    } else if constexpr (std::is_same<Type, MLogUtf8>::value) {
+        appendText(out, value.data, value.size);
+    } else if constexpr (std::is_pointer<Type>::value) {
+        appendPointer(out, static_cast<const void *>(value));
+    } else {
+        static_assert(IsDebugStreamable<Type>::value,
+                      "mlog: argument type can not be formatted");
+        static thread_local QString text;
+        text.resize(0);
+        QDebug(&text).nospace().noquote() << value;
+        appendDebugText(out, text);
+    }
+}
+
+template <typename T>
+void appendErased(QByteArray &out, const void *value)
+{
+    appendValue(out, *static_cast<const T *>(value));
+}
+
+void logFormatted(const QtMsgType type, const QLoggingCategory &category, const char *format,
+                  const int size, const Argument *arguments, const int count);
+
+inline const QLoggingCategory &category(const QLoggingCategory &category)
+{
+    return category;
+}
+
+//! \internal Category declared with Q_LOGGING_CATEGORY, passed without ()
+inline const QLoggingCategory &category(const QLoggingCategory &(*category)())
+{
+    return category();
+}
+
+template <typename Category, typename... Args>
+void log(const QtMsgType type, const Category &category, const FormatString<sizeof...(Args)> &format,
+         const Args &... args)
+{
+    const QLoggingCategory &target = detail::category(category);
+    if (target.isEnabled(type) == false)
+        return;
+
+    // Extra element keeps the array valid without arguments
+    const Argument arguments[] = { { &args, &appendErased<Args> }..., { nullptr, nullptr } };
+    logFormatted(type, target, format.text(), format.size(), arguments, int(sizeof...(Args)));
+}
+
+}
+
+//! Logs debug message in \a category, see mlog namespace
+template <typename Category, typename... Args>
+void debug(const Category &category, const FormatString<sizeof...(Args)> format,
+           const Args &... args)
+{
+#if MLOG_COMPILED_LOG_LEVEL >= 5
+    detail::log(QtDebugMsg, category, format, args...);
+#else
+    Q_UNUSED(category)
+    Q_UNUSED(format)
+    ((void)args, ...);
+#endif
+}
+
+//! Logs info message in \a category, see mlog namespace
+template <typename Category, typename... Args>
+void info(const Category &category, const FormatString<sizeof...(Args)> format,
+          const Args &... args)
+{
+#if MLOG_COMPILED_LOG_LEVEL >= 4
+    detail::log(QtInfoMsg, category, format, args...);
+#else
+    Q_UNUSED(category)
+    Q_UNUSED(format)
+    ((void)args, ...);
+#endif
+}
+
+//! Logs warning in \a category, see mlog namespace
+template <typename Category, typename... Args>
+void warning(const Category &category, const FormatString<sizeof...(Args)> format,
+             const Args &... args)
+{
+#if MLOG_COMPILED_LOG_LEVEL >= 3
+    detail::log(QtWarningMsg, category, format, args...);
+#else
+    Q_UNUSED(category)
+    Q_UNUSED(format)
+    ((void)args, ...);
+#endif
+}
+
+//! Logs critical message in \a category, see mlog namespace
+template <typename Category, typename... Args>
+void critical(const Category &category, const FormatString<sizeof...(Args)> format,
+              const Args &... args)
+{
+#if MLOG_COMPILED_LOG_LEVEL >= 2
+    detail::log(QtCriticalMsg, category, format, args...);
+#else
+    Q_UNUSED(category)
+    Q_UNUSED(format)
+    ((void)args, ...);
+#endif
+}
+
+}
@@ -0,0 +1,705 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogformatter.h"
+#include "mlogutf8.h"
+#include "mlogjson.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(Q_OS_DARWIN)
+#include <pthread.h>
+#endif
+
+namespace {
+
+/*!
+ * \internal
+ * Appends lower case hexadecimal representation of \a value to \a out.
+ */
+void appendHex(QByteArray &out, quint64 value)
+{
+    static const char digits[] = "0123456789abcdef";
+    char buffer[16];
+    char *end = buffer + sizeof(buffer);
+    char *pos = end;
+    do {
+        *--pos = digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+    out.append(pos, int(end - pos));
+}
+
+const char *typeName(const QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return "debug";
+    case QtInfoMsg:
+        return "info";
+    case QtWarningMsg:
+        return "warning";
+    case QtCriticalMsg:
+        return "critical";
+    case QtFatalMsg:
+        return "fatal";
+    }
+
+    return "";
+}
+
+/*!
+ * \internal
+ * Splits QDateTime \a format into parts separated by "zzz" (milliseconds),
+ * skipping quoted text. Returns empty list if \a format contains other
+ * sub-second fields, which means it can't be rendered once per second.
+ *
+ * Formats with AM/PM markers are not split either, because they change the
+ * meaning of "h" in other parts.
+ */
+QStringList splitTimeFormat(const QString &format)
+{
+    QStringList parts;
+    QString part;
+    bool quoted = false;
+    bool amPm = false;
+    int i = 0;
+    while (i < format.size()) {
+        const QChar c = format.at(i);
+        if (c == QLatin1Char('\'')) {
+            quoted = !quoted;
+        } else if (!quoted && (c == QLatin1Char('a') || c == QLatin1Char('A'))) {
+            amPm = true;
+        } else if (!quoted && c == QLatin1Char('z')) {
+            int run = 1;
+            while (i + run < format.size() && format.at(i + run) == QLatin1Char('z'))
+                ++run;
+            if (run != 3)
+                return QStringList();
+
+            parts.append(part);
+            part.clear();
+            i += run;
+            continue;
+        }
+
+        part.append(c);
+        ++i;
+    }
+
+    if (amPm && parts.isEmpty() == false)
+        return QStringList();
+
+    parts.append(part);
+    return parts;
+}
+
+/*!
+ * \internal
+ * Appends \a value as 3 digits (milliseconds).
+ */
+void appendMilliseconds(QByteArray &out, const int value)
+{
+    const char digits[3] = {
+        char('0' + value / 100),
+        char('0' + (value / 10) % 10),
+        char('0' + value % 10)
+    };
+    out.append(digits, 3);
+}
+
+/*!
+ * \internal
+ * Strips \a info (as produced by Q_FUNC_INFO) down to the function name: drops
+ * return type, argument list and template arguments. This is the same
+ * algorithm Qt uses for %{function}.
+ */
+QByteArray cleanupFuncinfo(QByteArray info)
+{
+    if (info.isEmpty())
+        return info;
+
+    int pos;
+
+    // Skip trailing [with XXX] for templates (gcc), but make
+    // sure to not affect Objective-C message names.
+    pos = info.size() - 1;
+    if (info.endsWith(']') && !(info.startsWith('+') || info.startsWith('-'))) {
+        while (--pos) {
+            if (info.at(pos) == '[')
+                info.truncate(pos);
+        }
+    }
+
+    // operator names with '(', ')', '<', '>' in it
+    static const char operator_call[] = "operator()";
+    static const char operator_lessThan[] = "operator<";
+    static const char operator_greaterThan[] = "operator>";
+    static const char operator_lessThanEqual[] = "operator<=";
+    static const char operator_greaterThanEqual[] = "operator>=";
+
+    // canonize operator names
+    info.replace("operator ", "operator");
+
+    // remove argument list
+    for (;;) {
+        int parencount = 0;
+        pos = info.lastIndexOf(')');
+        if (pos == -1) {
+            // Don't know how to parse this function name
+            return info;
+        }
+
+        // find the beginning of the argument list
+        --pos;
+        ++parencount;
+        while (pos && parencount) {
+            if (info.at(pos) == ')')
+                ++parencount;
+            else if (info.at(pos) == '(')
+                --parencount;
+            --pos;
+        }
+        if (parencount != 0)
+            return info;
+
+        info.truncate(++pos);
+
+        if (info.at(pos - 1) == ')') {
+            if (info.indexOf(operator_call) == pos - int(std::strlen(operator_call)))
+                break;
+
+            // this function returns a pointer to a function
+            // and we matched the arguments of the return type's parameter list
+            // try again
+            info.remove(0, info.indexOf('('));
+            info.chop(1);
+            continue;
+        } else {
+            break;
+        }
+    }
+
+    // find the beginning of the function name
+    int parencount = 0;
+    int templatecount = 0;
+    --pos;
+
+    // make sure special characters in operator names are kept
+    if (pos > -1) {
+        switch (info.at(pos)) {
+        case ')':
+            if (info.indexOf(operator_call) == pos - int(std::strlen(operator_call)) + 1)
+                pos -= 2;
+            break;
+        case '<':
+            if (info.indexOf(operator_lessThan) == pos - int(std::strlen(operator_lessThan)) + 1)
+                --pos;
+            break;
+        case '>':
+            if (info.indexOf(operator_greaterThan) == pos - int(std::strlen(operator_greaterThan)) + 1)
+                --pos;
+            break;
+        case '=': {
+            const int operatorLength = int(std::strlen(operator_lessThanEqual));
+            if (info.indexOf(operator_lessThanEqual) == pos - operatorLength + 1)
+                pos -= 2;
+            else if (info.indexOf(operator_greaterThanEqual) == pos - operatorLength + 1)
+                pos -= 2;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    while (pos > -1) {
+        if (parencount < 0 || templatecount < 0)
+            return info;
+
+        const char c = info.at(pos);
+        if (c == ')')
+            ++parencount;
+        else if (c == '(')
+            --parencount;
+        else if (c == '>')
+            ++templatecount;
+        else if (c == '<')
+            --templatecount;
+        else if (c == ' ' && templatecount == 0 && parencount == 0)
+            break;
+
+        --pos;
+    }
+    info = info.mid(pos + 1);
+
+    // remove trailing '*', '&' that are part of the return argument
+    while (info.startsWith('*') || info.startsWith('&'))
+        info = info.mid(1);
+
+    // we have the full function name now.
+    // clean up the templates
+    while ((pos = info.lastIndexOf('>')) != -1) {
+        if (!info.contains('<'))
+            break;
+
+        // find the matching close
+        const int end = pos;
+        templatecount = 1;
+        --pos;
+        while (pos && templatecount) {
+            const char c = info.at(pos);
+            if (c == '>')
+                ++templatecount;
+            else if (c == '<')
+                --templatecount;
+            --pos;
+        }
+        ++pos;
+        info.remove(pos, end - pos + 1);
+    }
+
+    return info;
+}
+
+}
+
+/*!
+ * \class MLogFormatter
+ * \internal
+ * \brief Compiled message pattern
+ *
+ * qFormatLogMessage() walks the message pattern for every message and builds
+ * several temporary QStrings. MLogFormatter parses the pattern once, in the
+ * same way Qt does, into a list of tokens (literals, %{time}, %{type},
+ * %{category}, %{function}, %{message}, ...) and renders them directly into a
+ * reusable UTF-8 buffer. Output is byte-identical to qFormatLogMessage().
+ *
+ * Cleaned up function names (%{function}) are cached per Q_FUNC_INFO pointer.
+ *
+ * Placeholders which can't be rendered outside of Qt (%{backtrace},
+ * %{time process}, %{time boot}, unknown placeholders, nested conditions) make
+ * the formatter fall back to qFormatLogMessage() for the whole pattern.
+ */
+
+/*!
+ * Compiles \a pattern. Syntax is the same as in qSetMessagePattern().
+ */
+MLogFormatter::MLogFormatter(const QString &pattern)
+    : m_pattern(pattern)
+{
+    m_compiled = compile(pattern);
+    if (m_compiled == false)
+        m_tokens.clear();
+}
+
+/*!
+ * Returns formatter of \a pattern, shared by everybody using the same
+ * pattern, so that each message is formatted once per distinct pattern.
+ * Formatters are created on first use and live until the application quits
+ * (they are never removed, and there are only a few patterns), so the
+ * pointer can be used from any thread without further locking.
+ */
+const MLogFormatter *MLogFormatter::shared(const QString &pattern)
+{
+    static QMutex mutex;
+    static std::map<QString, std::unique_ptr<const MLogFormatter>> formatters;
+
+    QMutexLocker locker(&mutex);
+    std::unique_ptr<const MLogFormatter> &formatter = formatters[pattern];
+    if (formatter == nullptr)
+        formatter.reset(new MLogFormatter(pattern));
+    return formatter.get();
+}
+
+/*!
+ * Returns the message pattern.
+ */
+QString MLogFormatter::pattern() const
+{
+    return m_pattern;
+}
+
+/*!
+ * Returns false if the pattern uses placeholders which MLogFormatter does not
+ * support. In such case format() uses qFormatLogMessage().
+ */
+bool MLogFormatter::isCompiled() const
+{
+    return m_compiled;
+}
+
+/*!
+ * Makes %{appname} and %{pid} render \a appName and \a pid instead of values
+ * of the current application. Used when decoding logs of another process.
+ */
+void MLogFormatter::setApplication(const QString &appName, const qint64 pid)
+{
+    m_hasApplication = true;
+    m_appName = appName;
+    m_pid = pid;
+}
+
+/*!
+ * Appends \a message formatted according to the pattern to \a out, encoded as
+ * UTF-8. Newline is not appended.
+ */
+void MLogFormatter::format(QByteArray &out, const MLogMessage &message) const
+{
+    if (m_compiled == false) {
+        const QMessageLogContext context(message.file, message.line,
+                                         message.function, message.category);
+        QString text = message.utf8.isNull() ? message.message
+                                             : QString::fromUtf8(message.utf8);
+        if (message.fields.isEmpty() == false) {
+            QByteArray fields;
+            mlog::appendFields(fields, message.fields);
+            text.append(QString::fromUtf8(fields));
+        }
+        mlog::appendUtf8(out, qFormatLogMessage(message.type, context, text));
+        return;
+    }
+
+    for (int i = 0; i < m_tokens.size(); ++i) {
+        const Token &token = m_tokens.at(i);
+        switch (token.type) {
+        case TokenType::Literal:
+            out.append(token.text);
+            break;
+        case TokenType::AppName:
+            mlog::appendUtf8(out, m_hasApplication ? m_appName
+                                                   : QCoreApplication::applicationName());
+            break;
+        case TokenType::Category:
+            mlog::appendLatin1(out, message.category);
+            break;
+        case TokenType::File:
+            mlog::appendLatin1(out, message.file ? message.file : "unknown");
+            break;
+        case TokenType::Function:
+            if (message.function) {
+                const QByteArray &function = cleanupFunctionName(message.function);
+                mlog::appendLatin1(out, function.constData(), function.size());
+            } else {
+                out.append("unknown");
+            }
+            break;
+        case TokenType::Line:
+            mlog::appendNumber(out, message.line);
+            break;
+        case TokenType::Message:
+            mlog::appendMessageText(out, message);
+            mlog::appendFields(out, message.fields);
+            break;
+        case TokenType::Pid:
+            mlog::appendNumber(out, m_hasApplication ? m_pid
+                                               : QCoreApplication::applicationPid());
+            break;
+        case TokenType::ThreadId:
+            mlog::appendNumber(out, message.threadId);
+            break;
+        case TokenType::ThreadPointer:
+            out.append("0x");
+            appendHex(out, message.threadPointer);
+            break;
+        case TokenType::Time:
+            appendTime(out, token, message.timestamp);
+            break;
+        case TokenType::Type:
+            out.append(typeName(message.type));
+            break;
+        case TokenType::IfCategory:
+        case TokenType::IfDebug:
+        case TokenType::IfInfo:
+        case TokenType::IfWarning:
+        case TokenType::IfCritical:
+        case TokenType::IfFatal:
+            if (isConditionMet(token, message) == false)
+                i = token.endIf;
+            break;
+        case TokenType::EndIf:
+            break;
+        }
+    }
+}
+
+/*!
+ * Appends \a timestamp (milliseconds since epoch) rendered according to time
+ * \a token to \a out.
+ *
+ * Most consecutive messages are logged within the same second, so everything
+ * except milliseconds is rendered once per second and cached (per thread).
+ * Milliseconds ("zzz") are rendered directly into \a out.
+ */
+void MLogFormatter::appendTime(QByteArray &out, const Token &token,
+                               const qint64 timestamp) const
+{
+    if (token.timeParts.isEmpty()) {
+        // Format with sub-second fields other than "zzz", render everything
+        const QDateTime time(QDateTime::fromMSecsSinceEpoch(timestamp));
+        mlog::appendUtf8(out, time.toString(token.timeFormat));
+        return;
+    }
+
+    struct TimeCache {
+        quint64 id = 0;
+        qint64 second = 0;
+        QVector<QByteArray> parts;
+    };
+    // A few entries, so that patterns with several time tokens don't thrash
+    static thread_local TimeCache caches[4];
+
+    qint64 second = timestamp / 1000;
+    int milliseconds = int(timestamp % 1000);
+    if (milliseconds < 0) {
+        --second;
+        milliseconds += 1000;
+    }
+
+    TimeCache &cache = caches[token.timeCacheId % 4];
+    if (cache.id != token.timeCacheId || cache.second != second) {
+        const QDateTime time(QDateTime::fromMSecsSinceEpoch(second * 1000));
+        cache.parts.resize(token.timeParts.size());
+        for (int i = 0; i < token.timeParts.size(); ++i) {
+            const QString &part = token.timeParts.at(i);
+            cache.parts[i].resize(0);
+            if (token.timeFormat.isEmpty())
+                mlog::appendUtf8(cache.parts[i], time.toString(Qt::ISODate));
+            else if (part.isEmpty() == false)
+                mlog::appendUtf8(cache.parts[i], time.toString(part));
+        }
+        cache.id = token.timeCacheId;
+        cache.second = second;
+    }
+
+    for (int i = 0; i < cache.parts.size(); ++i) {
+        if (i > 0)
+            appendMilliseconds(out, milliseconds);
+        out.append(cache.parts.at(i));
+    }
+}
+
+/*!
+ * Returns \a function (Q_FUNC_INFO) stripped down to function name, exactly
+ * like Qt's %{function} does. Results are cached per thread, keyed by the
+ * \a function pointer, so the string is only parsed once.
+ */
+const QByteArray &MLogFormatter::cleanupFunctionName(const char *function)
+{
+    static thread_local QHash<const char *, QByteArray> cache;
+    const auto it = cache.constFind(function);
+    if (it != cache.constEnd())
+        return it.value();
+
+    return *cache.insert(function, cleanupFuncinfo(QByteArray(function)));
+}
+
+/*!
+ * Returns ID of the calling thread, the same value as %{threadid}.
+ */
+qint64 MLogFormatter::currentThreadId()
+{
+    static thread_local qint64 threadId = 0;
+    if (threadId == 0) {
+#if defined(Q_OS_LINUX)
+        threadId = qint64(syscall(SYS_gettid));
+#elif defined(Q_OS_DARWIN)
+        quint64 tid = 0;
+        pthread_threadid_np(nullptr, &tid);
+        threadId = qint64(tid);
+#else
+        threadId = qint64(qintptr(QThread::currentThreadId()));
+#endif
+    }
+    return threadId;
+}
+
+/*!
+ * Returns true if pattern uses %{qthreadptr}. Capturing QThread pointer
+ * creates QThread objects for foreign threads, so it is only done on demand.
+ */
+bool MLogFormatter::needsThreadPointer() const
+{
+    if (m_compiled == false)
+        return false;
+
+    for (const Token &token : m_tokens) {
+        if (token.type == TokenType::ThreadPointer)
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Parses \a pattern into tokens, the same way Qt does. Returns false if the
+ * pattern can't be rendered without Qt.
+ */
+bool MLogFormatter::compile(const QString &pattern)
+{
+    // Split into literals and %{placeholders}
+    QStringList lexemes;
+    QString current;
+    bool inPlaceholder = false;
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == QLatin1Char('%') && !inPlaceholder) {
+            if ((i + 1 < pattern.size()) && pattern.at(i + 1) == QLatin1Char('{')) {
+                // beginning of placeholder
+                if (!current.isEmpty()) {
+                    lexemes.append(current);
+                    current.clear();
+                }
+                inPlaceholder = true;
+            }
+        }
+
+        current.append(c);
+
+        if (c == QLatin1Char('}') && inPlaceholder) {
+            // end of placeholder
+            lexemes.append(current);
+            current.clear();
+            inPlaceholder = false;
+        }
+    }
+    if (!current.isEmpty())
+        lexemes.append(current);
+
+    struct Placeholder {
+        const char *name;
+        TokenType type;
+    };
+    static const Placeholder placeholders[] = {
+        { "%{appname}", TokenType::AppName },
+        { "%{category}", TokenType::Category },
+        { "%{file}", TokenType::File },
+        { "%{function}", TokenType::Function },
+        { "%{line}", TokenType::Line },
+        { "%{message}", TokenType::Message },
+        { "%{pid}", TokenType::Pid },
+        { "%{threadid}", TokenType::ThreadId },
+        { "%{qthreadptr}", TokenType::ThreadPointer },
+        { "%{type}", TokenType::Type },
+        { "%{if-category}", TokenType::IfCategory },
+        { "%{if-debug}", TokenType::IfDebug },
+        { "%{if-info}", TokenType::IfInfo },
+        { "%{if-warning}", TokenType::IfWarning },
+        { "%{if-critical}", TokenType::IfCritical },
+        { "%{if-fatal}", TokenType::IfFatal },
+        { "%{endif}", TokenType::EndIf }
+    };
+
+    int openCondition = -1;
+    for (const QString &lexeme : qAsConst(lexemes)) {
+        Token token;
+        if (lexeme.startsWith(QLatin1String("%{")) && lexeme.endsWith(QLatin1Char('}'))) {
+            bool known = false;
+            for (const Placeholder &placeholder : placeholders) {
+                if (lexeme == QLatin1String(placeholder.name)) {
+                    token.type = placeholder.type;
+                    known = true;
+                    break;
+                }
+            }
+
+            if (known == false && lexeme.startsWith(QLatin1String("%{time"))) {
+                token.type = TokenType::Time;
+                const int spaceIdx = lexeme.indexOf(QLatin1Char(' '));
+                if (spaceIdx > 0)
+                    token.timeFormat = lexeme.mid(spaceIdx + 1, lexeme.size() - spaceIdx - 2);
+                // Qt measures these from its own internal timers
+                if (token.timeFormat == QLatin1String("process")
+                        || token.timeFormat == QLatin1String("boot")) {
+                    return false;
+                }
+
+                static std::atomic<quint64> lastTimeCacheId{0};
+                token.timeCacheId = ++lastTimeCacheId;
+                if (token.timeFormat.isEmpty())
+                    token.timeParts.append(QString());
+                else
+                    token.timeParts = splitTimeFormat(token.timeFormat);
+                known = true;
+            }
+
+            // %{backtrace} or something we don't know - let Qt handle it
+            if (known == false)
+                return false;
+
+            if (token.type == TokenType::EndIf) {
+                if (openCondition == -1)
+                    return false;
+                m_tokens[openCondition].endIf = m_tokens.size();
+                openCondition = -1;
+            } else if (token.type >= TokenType::IfCategory) {
+                // Qt does not support nested conditions
+                if (openCondition != -1)
+                    return false;
+                openCondition = m_tokens.size();
+            }
+        } else {
+            token.text = lexeme.toUtf8();
+        }
+
+        m_tokens.append(token);
+    }
+
+    return openCondition == -1;
+}
+
+/*!
+ * Returns true if condition of \a token is met for \a message.
+ */
+bool MLogFormatter::isConditionMet(const Token &token,
+                                   const MLogMessage &message) const
+{
+    switch (token.type) {
+    case TokenType::IfCategory:
+        return message.category && std::strcmp(message.category, "default") != 0;
+    case TokenType::IfDebug:
+        return message.type == QtDebugMsg;
+    case TokenType::IfInfo:
+        return message.type == QtInfoMsg;
+    case TokenType::IfWarning:
+        return message.type == QtWarningMsg;
+    case TokenType::IfCritical:
+        return message.type == QtCriticalMsg;
+    case TokenType::IfFatal:
+        return message.type == QtFatalMsg;
+    default:
+        return true;
+    }
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "mlogmessage.h"
+
+/*!
+ * \internal
+ * Message pattern (see qSetMessagePattern()) parsed once into a list of
+ * formatting operations, which are then rendered straight into a UTF-8 buffer.
+ */
+class MLogFormatter
+{
+public:
+    explicit MLogFormatter(const QString &pattern = QString());
+
+    QString pattern() const;
+    bool isCompiled() const;
+    bool needsThreadPointer() const;
+    void setApplication(const QString &appName, const qint64 pid);
+
+    void format(QByteArray &out, const MLogMessage &message) const;
+
+    static const MLogFormatter *shared(const QString &pattern);
+    static const QByteArray &cleanupFunctionName(const char *function);
+    static qint64 currentThreadId();
+
+private:
+    enum class TokenType {
+        Literal,
+        AppName,
+        Category,
+        File,
+        Function,
+        Line,
+        Message,
+        Pid,
+        ThreadId,
+        ThreadPointer,
+        Time,
+        Type,
+        IfCategory,
+        IfDebug,
+        IfInfo,
+        IfWarning,
+        IfCritical,
+        IfFatal,
+        EndIf
+    };
+
+    struct Token {
+        TokenType type = TokenType::Literal;
+        //! UTF-8 text of a literal
+        QByteArray text;
+        //! QDateTime format of a time token, empty means Qt::ISODate
+        QString timeFormat;
+        //! timeFormat split at "zzz", empty if it can't be cached per second
+        QStringList timeParts;
+        //! Identifies the token in per-thread time cache
+        quint64 timeCacheId = 0;
+        //! Index of matching EndIf for conditional tokens
+        int endIf = -1;
+    };
+
+    bool compile(const QString &pattern);
+    bool isConditionMet(const Token &token, const MLogMessage &message) const;
+    void appendTime(QByteArray &out, const Token &token, const qint64 timestamp) const;
+
+    QString m_pattern;
+    QVector<Token> m_tokens;
+    bool m_compiled = false;
+    bool m_hasApplication = false;
+    QString m_appName;
+    qint64 m_pid = 0;
+};
@@ -0,0 +1,138 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mloggzip.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+
+//! Size of data compressed at once, each chunk becomes one gzip member
+const qint64 chunkSize = 1024 * 1024;
+
+quint32 crc32(const char *data, const qint64 size)
+{
+    static const struct Table {
+        quint32 values[256];
+        Table()
+        {
+            for (quint32 i = 0; i < 256; ++i) {
+                quint32 value = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value & 1) ? (0xedb88320u ^ (value >> 1)) : (value >> 1);
+                values[i] = value;
+            }
+        }
+    } table;
+
+    quint32 crc = 0xffffffffu;
+    for (qint64 i = 0; i < size; ++i)
+        crc = table.values[(crc ^ quint8(data[i])) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+void appendUInt32(QByteArray &out, const quint32 value)
+{
+    char buffer[4];
+    qToLittleEndian(value, buffer);
+    out.append(buffer, 4);
+}
+
+/*!
+ * Appends gzip member holding \a chunk, compressed with \a level, to \a out.
+ *
+ * qCompress() produces a 4 byte size followed by a zlib stream: 2 byte
+ * header, raw deflate data and Adler-32 checksum. gzip wants the same raw
+ * deflate data, wrapped in its own header and a CRC-32 trailer.
+ */
+void appendMember(QByteArray &out, const QByteArray &chunk, const int level)
+{
+    static const char header[10] = {
+        '\x1f', '\x8b', // magic
+        '\x08', // deflate
+        '\x00', // no flags
+        '\x00', '\x00', '\x00', '\x00', // no modification time
+        '\x00', // no extra flags
+        '\xff' // unknown OS
+    };
+    out.append(header, 10);
+
+    const QByteArray compressed = qCompress(chunk, level);
+    if (compressed.size() > 4 + 2 + 4) {
+        out.append(compressed.constData() + 4 + 2, compressed.size() - 4 - 2 - 4);
+    } else {
+        // Empty input, qCompress() returns only the size. Empty final block
+        out.append("\x03\x00", 2);
+    }
+
+    appendUInt32(out, crc32(chunk.constData(), chunk.size()));
+    appendUInt32(out, quint32(chunk.size()));
+}
+
+}
+
+namespace mlog {
+
+/*!
+ * \internal
+ * Compresses \a source into gzip file \a target, with zlib compression
+ * \a level (0-9, -1 for default). Large files become multi-member gzip
+ * files, which gzip, zcat and zlib read as a whole.
+ *
+ * \a interrupted is checked after each chunk. If it returns true, the
+ * partial \a target is removed and false is returned. \a source is never
+ * modified.
+ */
+bool gzipFile(const QString &source, const QString &target, const int level,
+              const std::function<bool()> &interrupted)
+{
+    QFile input(source);
+    QFile output(target);
+    if (input.open(QFile::ReadOnly) == false
+            || output.open(QFile::WriteOnly | QFile::Truncate) == false) {
+        return false;
+    }
+
+    QByteArray member;
+    bool ok = true;
+    do {
+        const QByteArray chunk = input.read(chunkSize);
+        member.resize(0);
+        appendMember(member, chunk, level);
+        if (output.write(member) != member.size() || (interrupted && interrupted())) {
+            ok = false;
+            break;
+        }
+    } while (input.atEnd() == false);
+
+    output.close();
+    if (ok == false || output.error() != QFile::NoError) {
+        output.remove();
+        return false;
+    }
+    return true;
+}
+
+}
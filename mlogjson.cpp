@@ -0,0 +1,304 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogjson.h"
+#include "mlogformatter.h"
+#include "mlogutf8.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char *levelName(const QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return "debug";
+    case QtInfoMsg:
+        return "info";
+    case QtWarningMsg:
+        return "warning";
+    case QtCriticalMsg:
+        return "critical";
+    case QtFatalMsg:
+        return "fatal";
+    }
+
+    return "";
+}
+
+inline bool needsEscaping(const uchar c)
+{
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+/*!
+ * \internal
+ * Appends ASCII character \a c to \a out, escaped as required by JSON.
+ */
+void appendEscaped(QByteArray &out, const uchar c)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    switch (c) {
+    case '"':
+        out.append("\\\"", 2);
+        break;
+    case '\\':
+        out.append("\\\\", 2);
+        break;
+    case '\n':
+        out.append("\\n", 2);
+        break;
+    case '\r':
+        out.append("\\r", 2);
+        break;
+    case '\t':
+        out.append("\\t", 2);
+        break;
+    case '\b':
+        out.append("\\b", 2);
+        break;
+    case '\f':
+        out.append("\\f", 2);
+        break;
+    default:
+        if (c < 0x20) {
+            const char escape[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4],
+                                     hexDigits[c & 0xf] };
+            out.append(escape, 6);
+        } else {
+            out.append(char(c));
+        }
+        break;
+    }
+}
+
+/*!
+ * \internal
+ * Appends ",\"<key>\":" to \a out. Keys are plain ASCII literals and are not
+ * escaped.
+ */
+void appendKey(QByteArray &out, const char *key)
+{
+    out.append(",\"", 2);
+    out.append(key);
+    out.append("\":", 2);
+}
+
+/*!
+ * \internal
+ * Escapes characters of \a out from \a start on, as required by JSON.
+ *
+ * Text is encoded first and checked for characters which need escaping
+ * afterwards. Those are rare, so usually the string is copied only once.
+ */
+void escapeTail(QByteArray &out, const int start)
+{
+    int pos = start;
+    while (pos < out.size() && needsEscaping(uchar(out.at(pos))) == false)
+        ++pos;
+
+    if (pos < out.size()) {
+        // UTF-8 continuation bytes are >= 0x80, so escaping byte by byte is
+        // safe
+        static thread_local QByteArray tail;
+        tail.resize(0);
+        tail.append(out.constData() + pos, out.size() - pos);
+        out.resize(pos);
+        for (int i = 0; i < tail.size(); ++i)
+            appendEscaped(out, uchar(tail.at(i)));
+    }
+}
+
+}
+
+/*!
+ * \internal
+ * Appends \a string to \a out as a quoted JSON string, encoded as UTF-8.
+ */
+void mlog::appendJsonString(QByteArray &out, const QString &string)
+{
+    out.append('"');
+    const int start = out.size();
+    mlog::appendUtf8(out, string);
+    escapeTail(out, start);
+    out.append('"');
+}
+
+/*!
+ * \internal
+ * Appends UTF-8 encoded \a text to \a out as a quoted JSON string, without
+ * converting it.
+ */
+void mlog::appendJsonUtf8(QByteArray &out, const QByteArray &text)
+{
+    out.append('"');
+    const int start = out.size();
+    out.append(text);
+    escapeTail(out, start);
+    out.append('"');
+}
+
+/*!
+ * \internal
+ * Appends Latin-1 encoded \a text to \a out as a quoted JSON string, encoded
+ * as UTF-8. If \a size is negative, \a text is null-terminated.
+ */
+void mlog::appendJsonLatin1(QByteArray &out, const char *text, int size)
+{
+    out.append('"');
+    if (text) {
+        if (size < 0)
+            size = int(std::strlen(text));
+
+        for (int i = 0; i < size; ++i) {
+            const uchar c = uchar(text[i]);
+            if (c < 0x80) {
+                appendEscaped(out, c);
+            } else {
+                out.append(char(0xc0 | (c >> 6)));
+                out.append(char(0x80 | (c & 0x3f)));
+            }
+        }
+    }
+    out.append('"');
+}
+
+/*!
+ * \internal
+ * Appends value of \a field to \a out as JSON. Numbers which JSON can not
+ * represent (infinity and NaN) are written as null.
+ */
+void mlog::appendJsonValue(QByteArray &out, const MLogField &field)
+{
+    switch (field.type) {
+    case MLogField::Type::Bool:
+        if (field.integer)
+            out.append("true", 4);
+        else
+            out.append("false", 5);
+        break;
+    case MLogField::Type::Integer:
+        mlog::appendNumber(out, field.integer);
+        break;
+    case MLogField::Type::Double:
+        if (std::isfinite(field.real)) {
+            char buffer[32];
+            const int size = std::snprintf(buffer, sizeof(buffer), "%.17g", field.real);
+            // Qt applications run with system locale, which might use a
+            // decimal comma
+            for (int i = 0; i < size; ++i) {
+                if (buffer[i] == ',')
+                    buffer[i] = '.';
+            }
+            out.append(buffer, size);
+        } else {
+            out.append("null", 4);
+        }
+        break;
+    case MLogField::Type::String:
+        mlog::appendJsonString(out, field.string);
+        break;
+    }
+}
+
+/*!
+ * \internal
+ * Appends \a message to \a out as a single line JSON object (without the
+ * newline):
+ * \code
+ * {"time":1760643437123,"level":"info","category":"net","thread":1234,
+ *  "file":"main.cpp","line":42,"function":"main","message":"Request done",
+ *  "fields":{"bytes":512}}
+ * \endcode
+ *
+ * Time is in milliseconds since epoch. Keys without a value (for example
+ * file, when QT_MESSAGELOGCONTEXT is not defined) are left out, so are all
+ * the context keys for MLog::writeRaw() messages.
+ */
+void mlog::appendJsonRecord(QByteArray &out, const MLogMessage &message)
+{
+    out.append("{\"time\":", 8);
+    mlog::appendNumber(out, message.timestamp);
+    appendKey(out, "level");
+    out.append('"');
+    out.append(levelName(message.type));
+    out.append('"');
+
+    if (message.raw == false) {
+        if (message.category) {
+            appendKey(out, "category");
+            mlog::appendJsonLatin1(out, message.category);
+        }
+        appendKey(out, "thread");
+        mlog::appendNumber(out, message.threadId);
+        if (message.file) {
+            appendKey(out, "file");
+            mlog::appendJsonLatin1(out, message.file);
+            appendKey(out, "line");
+            mlog::appendNumber(out, message.line);
+        }
+        if (message.function) {
+            const QByteArray &function = MLogFormatter::cleanupFunctionName(message.function);
+            appendKey(out, "function");
+            mlog::appendJsonLatin1(out, function.constData(), function.size());
+        }
+    }
+
+    appendKey(out, "message");
+    if (message.utf8.isNull())
+        mlog::appendJsonString(out, message.message);
+    else
+        mlog::appendJsonUtf8(out, message.utf8);
+
+    if (message.fields.isEmpty() == false) {
+        appendKey(out, "fields");
+        char separator = '{';
+        for (const MLogField &field : message.fields) {
+            out.append(separator);
+            separator = ',';
+            mlog::appendJsonLatin1(out, field.key);
+            out.append(':');
+            mlog::appendJsonValue(out, field);
+        }
+        out.append('}');
+    }
+    out.append('}');
+}
+
+/*!
+ * \internal
+ * Appends \a fields to \a out as " key=value" pairs, used after message text
+ * in text output. Values are written as JSON, so strings are quoted.
+ */
+void mlog::appendFields(QByteArray &out, const QVector<MLogField> &fields)
+{
+    for (const MLogField &field : fields) {
+        out.append(' ');
+        mlog::appendLatin1(out, field.key);
+        out.append('=');
+        mlog::appendJsonValue(out, field);
+    }
+}
@@ -0,0 +1,47 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "mlogmessage.h"
+
+/*!
+ * \internal
+ * JSON encoding of log messages (see MLog::FileFormat::Json). Everything is
+ * written straight into the output buffer, without QJsonObject or temporary
+ * strings.
+ */
+namespace mlog {
+
+void appendJsonString(QByteArray &out, const QString &string);
+void appendJsonUtf8(QByteArray &out, const QByteArray &text);
+void appendJsonLatin1(QByteArray &out, const char *text, int size = -1);
+void appendJsonValue(QByteArray &out, const MLogField &field);
+void appendJsonRecord(QByteArray &out, const MLogMessage &message);
+void appendFields(QByteArray &out, const QVector<MLogField> &fields);
+
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "mlogrecord.h"
+#include "mlogutf8.h"
+
+/*!
+ * \internal
+ * A single log message, as received by MLog::messageHandler() or
+ * MLog::writeRaw(). This is what travels between producer threads and the
+ * asynchronous writer (see MLog::enableAsyncLogging()).
+ *
+ * Context strings (\c file, \c function and \c category) are not copied
+ * while the message is handled by the logging thread. They usually point to
+ * static data, but QML and other code building QMessageLogger at runtime
+ * frees them as soon as the message handler returns, so messages which are
+ * kept for later are detached first, see MLog::detachContext().
+ */
+struct MLogMessage
+{
+    QtMsgType type = QtDebugMsg;
+    int line = 0;
+    const char *file = nullptr;
+    const char *function = nullptr;
+    const char *category = nullptr;
+    //! Time of logging, in milliseconds since epoch
+    qint64 timestamp = 0;
+    //! ID of the logging thread (%{threadid})
+    qint64 threadId = 0;
+    //! QThread of the logging thread (%{qthreadptr}), only set when needed
+    quintptr threadPointer = 0;
+    QString message;
+    //! Message text encoded as UTF-8, set instead of \c message by MLog::logUtf8()
+    QByteArray utf8;
+    //! Fields of an MLogRecord, empty for plain qDebug() and friends
+    QVector<MLogField> fields;
+    //! True for MLog::writeRaw() messages, which are written without formatting
+    bool raw = false;
+    //! Copies of context strings, when they are not kept by the call site
+    //! registry. Shared (never detached) by copies of the message, so the
+    //! pointers above stay valid
+    QByteArray context;
+};
+
+namespace mlog {
+
+/*!
+ * \internal
+ * Appends text of \a message to \a out, encoded as UTF-8. UTF-8 messages
+ * are copied as they are.
+ */
+inline void appendMessageText(QByteArray &out, const MLogMessage &message)
+{
+    if (message.utf8.isNull())
+        appendUtf8(out, message.message);
+    else
+        out.append(message.utf8);
+}
+
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*!
+ * \internal
+ * Bounded, lock-free, multi-producer single-consumer queue.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence
+ * number which tells producers and the consumer whether the cell is free or
+ * holds a published value. Producers claim cells with a single CAS on the
+ * enqueue position, the consumer never needs a CAS at all.
+ *
+ * Capacity is rounded up to the nearest power of two. push() fails (without
+ * touching the value) when the queue is full.
+ */
+template <typename T>
+class MLogQueue
+{
+public:
+    explicit MLogQueue(const std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_mask = size - 1;
+        m_cells = new Cell[size];
+        for (std::size_t i = 0; i < size; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~MLogQueue()
+    {
+        delete[] m_cells;
+    }
+
+    MLogQueue(const MLogQueue &) = delete;
+    MLogQueue &operator=(const MLogQueue &) = delete;
+
+    /*!
+     * Moves \a value into the queue. Safe to call from any number of threads.
+     * Returns false if the queue is full, \a value is left untouched then.
+     */
+    bool push(T &&value)
+    {
+        Cell *cell = nullptr;
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence)
+                    - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * Moves the oldest published value into \a value. Must only be called from
+     * the single consumer thread. Returns false if there is nothing to pop.
+     */
+    bool pop(T &value)
+    {
+        const std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell = &m_cells[pos & m_mask];
+        const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (sequence != pos + 1)
+            return false;
+
+        value = std::move(cell->value);
+        // Do not keep moved-from (or swapped) data alive in the cell
+        cell->value = T();
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * Returns true if the consumer has nothing to pop right now. Consumer side
+     * only.
+     */
+    bool isEmpty() const
+    {
+        const std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        const Cell *cell = &m_cells[pos & m_mask];
+        return cell->sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    /*!
+     * Returns number of values pushed so far (including ones which are still
+     * being published).
+     */
+    std::size_t enqueuedCount() const
+    {
+        return m_enqueuePos.load(std::memory_order_acquire);
+    }
+
+    /*!
+     * Returns number of values popped so far.
+     */
+    std::size_t dequeuedCount() const
+    {
+        return m_dequeuePos.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    Cell *m_cells = nullptr;
+    std::size_t m_mask = 0;
+    // Keep producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+};
@@ -0,0 +1,151 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogrecord.h"
+
+namespace {
+
+//! Fields of the record which is being logged by this thread right now
+thread_local const QVector<MLogField> *sPendingFields = nullptr;
+
+}
+
+/*!
+ * \class MLogRecord
+ * \brief Structured log message
+ *
+ * Fields do not fit through Qt's message handler, which only receives a
+ * QString. MLogRecord logs its text with a regular QMessageLogger and makes
+ * the fields available, for the duration of that call, through
+ * pendingFields(). Message handler runs synchronously in the logging thread,
+ * so MLog picks them up from there.
+ */
+
+/*!
+ * Creates message of \a type in \a category. \a file, \a line and \a function
+ * describe the call site, like in QMessageLogContext.
+ */
+MLogRecord::MLogRecord(const QtMsgType type, const char *file, const int line,
+                       const char *function, const QLoggingCategory &category)
+    : m_type(type), m_file(file), m_line(line), m_function(function),
+      m_category(category), m_stream(&m_text)
+{
+}
+
+/*!
+ * Logs the message.
+ */
+MLogRecord::~MLogRecord()
+{
+    // QDebug separates items with spaces, including after the last one
+    if (m_text.endsWith(QLatin1Char(' ')))
+        m_text.chop(1);
+
+    sPendingFields = &m_fields;
+    QMessageLogger logger(m_file, m_line, m_function, m_category.categoryName());
+    switch (m_type) {
+    case QtDebugMsg:
+        logger.debug().noquote() << m_text;
+        break;
+    case QtInfoMsg:
+        logger.info().noquote() << m_text;
+        break;
+    case QtWarningMsg:
+        logger.warning().noquote() << m_text;
+        break;
+    case QtCriticalMsg:
+        logger.critical().noquote() << m_text;
+        break;
+    case QtFatalMsg:
+        logger.fatal("%s", qUtf8Printable(m_text));
+        break;
+    }
+    sPendingFields = nullptr;
+}
+
+/*!
+ * Adds boolean field \a key with \a value.
+ */
+MLogRecord &MLogRecord::field(const char *key, const bool value)
+{
+    MLogField entry;
+    entry.key = key;
+    entry.type = MLogField::Type::Bool;
+    entry.integer = value ? 1 : 0;
+    m_fields.append(entry);
+    return *this;
+}
+
+/*!
+ * Adds floating point field \a key with \a value.
+ */
+MLogRecord &MLogRecord::field(const char *key, const double value)
+{
+    MLogField entry;
+    entry.key = key;
+    entry.type = MLogField::Type::Double;
+    entry.real = value;
+    m_fields.append(entry);
+    return *this;
+}
+
+/*!
+ * Adds string field \a key with \a value.
+ */
+MLogRecord &MLogRecord::field(const char *key, const QString &value)
+{
+    MLogField entry;
+    entry.key = key;
+    entry.type = MLogField::Type::String;
+    entry.string = value;
+    m_fields.append(entry);
+    return *this;
+}
+
+/*!
+ * Adds string field \a key with UTF-8 encoded \a value.
+ */
+MLogRecord &MLogRecord::field(const char *key, const char *value)
+{
+    return field(key, QString::fromUtf8(value));
+}
+
+/*!
+ * Returns fields of the record which is being logged by the calling thread,
+ * or nullptr if the message being logged is not an MLogRecord. Only valid
+ * inside the Qt message handler.
+ */
+const QVector<MLogField> *MLogRecord::pendingFields()
+{
+    return sPendingFields;
+}
+
+MLogRecord &MLogRecord::integerField(const char *key, const qint64 value)
+{
+    MLogField entry;
+    entry.key = key;
+    entry.type = MLogField::Type::Integer;
+    entry.integer = value;
+    m_fields.append(entry);
+    return *this;
+}
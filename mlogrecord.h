@@ -0,0 +1,125 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QString>
+#include <QVector>
+
+#include <type_traits>
+
+/*!
+ * A typed key/value field attached to a log message, see MLogRecord.
+ *
+ * \c key is not copied, it has to be a string literal (or other static
+ * string), just like file and function names in QMessageLogContext.
+ */
+struct MLogField
+{
+    enum class Type {
+        Bool,
+        Integer,
+        Double,
+        String
+    };
+
+    const char *key = nullptr;
+    Type type = Type::Integer;
+    qint64 integer = 0;
+    double real = 0;
+    QString string;
+};
+
+/*!
+ * Builds a structured log message: typed fields plus optional text streamed
+ * just like into QDebug. The message is logged when the record is destroyed,
+ * use mRecord() and mCRecord() macros rather than creating it directly:
+ * \code
+ * mCRecord(QtInfoMsg, netLogger).field("bytes", size).field("peer", address)
+ *     << "Request done";
+ * \endcode
+ *
+ * Message goes through the Qt message handler like any other one. MLog
+ * writes fields as a JSON object when log file format is
+ * MLog::FileFormat::Json, and as " key=value" pairs after the message text
+ * otherwise.
+ */
+class MLogRecord
+{
+public:
+    MLogRecord(const QtMsgType type, const char *file, const int line,
+               const char *function, const QLoggingCategory &category);
+    ~MLogRecord();
+
+    MLogRecord &field(const char *key, const bool value);
+    MLogRecord &field(const char *key, const double value);
+    MLogRecord &field(const char *key, const QString &value);
+    MLogRecord &field(const char *key, const char *value);
+
+    //! Adds integer field \a key with \a value
+    template <typename T, typename std::enable_if<std::is_integral<T>::value
+                                                  && !std::is_same<T, bool>::value,
+                                                  int>::type = 0>
+    MLogRecord &field(const char *key, const T value)
+    {
+        return integerField(key, qint64(value));
+    }
+
+    //! Appends \a value to message text, see QDebug::operator<<()
+    template <typename T>
+    MLogRecord &operator<<(const T &value)
+    {
+        m_stream << value;
+        return *this;
+    }
+
+    static const QVector<MLogField> *pendingFields();
+
+private:
+    Q_DISABLE_COPY(MLogRecord)
+
+    MLogRecord &integerField(const char *key, const qint64 value);
+
+    QtMsgType m_type = QtDebugMsg;
+    const char *m_file = nullptr;
+    int m_line = 0;
+    const char *m_function = nullptr;
+    const QLoggingCategory &m_category;
+    QVector<MLogField> m_fields;
+    QString m_text;
+    QDebug m_stream;
+};
+
+//! Structured message of \a type in \a category, see MLogRecord
+#define mCRecord(type, category) \
+    for (bool mlogEnabled = category().isEnabled(type); mlogEnabled; mlogEnabled = false) \
+        MLogRecord(type, QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, category())
+
+//! Structured message of \a type in default category, see MLogRecord
+#define mRecord(type) \
+    for (bool mlogEnabled = QLoggingCategory::defaultCategory()->isEnabled(type); \
+         mlogEnabled; mlogEnabled = false) \
+        MLogRecord(type, QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC, \
+                   *QLoggingCategory::defaultCategory())
@@ -0,0 +1,461 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogrotation.h"
+#include "mloggzip.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+const int manifestVersion = 1;
+const char fileExt[] = ".log";
+const char compressedExt[] = ".gz";
+const char dateTimeFormat[] = "yyyy-MM-dd_HH-mm-ss";
+
+QString rotationName(const MLog::RotationType type)
+{
+    return type == MLog::RotationType::Consequent ? QStringLiteral("consequent")
+                                                  : QStringLiteral("datetime");
+}
+
+/*!
+ * Renames \a from to \a to, replacing \a to if it exists.
+ */
+void moveFile(const QString &from, const QString &to)
+{
+    if (from == to)
+        return;
+
+    if (QFile::rename(from, to) == false && QFile::exists(to)) {
+        QFile::remove(to);
+        QFile::rename(from, to);
+    }
+}
+
+}
+
+/*!
+ * \class MLogRotation
+ * \internal
+ * \brief Log rotation set of an application
+ *
+ * Manifest is a JSON file named <appName>.manifest:
+ * \code
+ * { "version": 1, "rotation": "consequent", "current": "App-current.log",
+ *   "logs": [ "App-previous.log", "App-previous-1.log" ] }
+ * \endcode
+ *
+ * Reading it costs one small file read plus one stat() per listed log,
+ * regardless of how many other files are in the log directory.
+ */
+
+/*!
+ * Creates rotation set of \a appName logs in \a directory, named according
+ * to \a type and limited to \a maxLogs files (including the current one).
+ */
+MLogRotation::MLogRotation(const QString &directory, const QString &appName,
+                           const MLog::RotationType type, const int maxLogs)
+    : m_directory(directory), m_appName(appName), m_type(type),
+      m_maxLogs(maxLogs)
+{
+}
+
+/*!
+ * Returns path of the current log file, opened at \a timestamp (ms since
+ * epoch).
+ */
+QString MLogRotation::currentLogPath(const qint64 timestamp) const
+{
+    if (m_type == MLog::RotationType::DateTime) {
+        const QString date = QDateTime::fromMSecsSinceEpoch(timestamp)
+                .toString(QLatin1String(dateTimeFormat));
+        return filePath(QString(m_appName + '-' + date + QLatin1String(fileExt)));
+    }
+
+    return filePath(QString(m_appName + QLatin1String("-current") + QLatin1String(fileExt)));
+}
+
+/*!
+ * Returns unique path to which current log is moved when it is rotated at
+ * \a timestamp, while the application is running. \a count is the number of
+ * rotations done so far. rotate() later moves the file to its place in the
+ * rotation set.
+ */
+QString MLogRotation::rotatedLogPath(const qint64 timestamp,
+                                     const quint64 count) const
+{
+    return filePath(QString(m_appName + QLatin1String("-rotated-")
+                            + QString::number(timestamp) + '-'
+                            + QString::number(count) + QLatin1String(fileExt)));
+}
+
+/*!
+ * Returns path of the previous log, which is known up front only for
+ * Consequent rotation. Returns an empty string for DateTime rotation, see
+ * startup().
+ */
+QString MLogRotation::previousLogPath() const
+{
+    if (m_type == MLog::RotationType::Consequent)
+        return filePath(previousLogName(0));
+    return QString();
+}
+
+/*!
+ * Returns path of the manifest file.
+ */
+QString MLogRotation::manifestPath() const
+{
+    return filePath(QString(m_appName + QLatin1String(".manifest")));
+}
+
+/*!
+ * Rotates logs when application starts logging into \a currentLogPath. Log
+ * written during the previous run is moved into the rotation set.
+ *
+ * For Consequent rotation \a closedLogPath is where that log is now. It is
+ * either \a currentLogPath itself or the path it was moved to, so that the
+ * new log could be opened before rotation. DateTime rotation finds previous
+ * log in the manifest and ignores \a closedLogPath.
+ *
+ * Consequent logs renamed by rotatedLogPath() which were never moved into the
+ * set, because the application exited before the worker got to them, are
+ * moved in here as well, ahead of the closed log.
+ *
+ * Returns path of the previous log.
+ */
+QString MLogRotation::startup(const QString &currentLogPath,
+                              const QString &closedLogPath) const
+{
+    Manifest manifest = loadManifest();
+
+    QString previousLogPath = closedLogPath;
+    if (m_type == MLog::RotationType::DateTime) {
+        previousLogPath = manifest.current.isEmpty() ? QString()
+                                                     : filePath(manifest.current);
+        // Started twice within a second, the file is going to be overwritten
+        if (previousLogPath == currentLogPath)
+            previousLogPath.clear();
+    }
+
+    QStringList closedLogs = { previousLogPath };
+    if (m_type == MLog::RotationType::Consequent) {
+        // Closed log is one of them when started in the background
+        closedLogs = pendingRotatedLogs();
+        if (closedLogs.contains(closedLogPath) == false
+                && QFileInfo::exists(closedLogPath)) {
+            closedLogs.append(closedLogPath);
+        }
+        // Oldest ones would be shifted out of the set anyway
+        while (closedLogs.size() > maxPreviousLogs())
+            QFile::remove(closedLogs.takeFirst());
+    }
+
+    // Directory scan might have found the new log, if it is already open
+    manifest.logs.removeAll(QFileInfo(currentLogPath).fileName());
+    for (const QString &log : qAsConst(closedLogs))
+        addClosedLog(manifest, log);
+    removeExcessLogs(manifest);
+    manifest.current = QFileInfo(currentLogPath).fileName();
+    writeManifest(manifest);
+
+    if (m_type == MLog::RotationType::Consequent)
+        return previousLogPath();
+    return manifest.logs.isEmpty() ? QString() : filePath(manifest.logs.first());
+}
+
+/*!
+ * Moves \a closedLogPath, which has just stopped being the current log, into
+ * the rotation set and removes logs above the limit. \a currentLogPath is the
+ * log file opened in its place.
+ */
+void MLogRotation::rotate(const QString &closedLogPath,
+                          const QString &currentLogPath) const
+{
+    Manifest manifest = loadManifest();
+    manifest.logs.removeAll(QFileInfo(currentLogPath).fileName());
+    addClosedLog(manifest, closedLogPath);
+    removeExcessLogs(manifest);
+    manifest.current = QFileInfo(currentLogPath).fileName();
+    writeManifest(manifest);
+}
+
+/*!
+ * Compresses all logs in the rotation set which are not compressed yet with
+ * zlib compression \a level. Current log is never touched.
+ *
+ * \a interrupted is checked regularly, when it returns true compression
+ * stops (leaving the set consistent) and false is returned. Returns true once
+ * all logs are compressed.
+ */
+bool MLogRotation::compress(const int level,
+                            const std::function<bool()> &interrupted) const
+{
+    Manifest manifest = loadManifest();
+    for (int i = 0; i < manifest.logs.size(); ++i) {
+        const QString name = manifest.logs.at(i);
+        if (name.endsWith(QLatin1String(compressedExt)))
+            continue;
+
+        const QString compressedName = name + QLatin1String(compressedExt);
+        const QString partPath = filePath(QString(compressedName + QLatin1String(".part")));
+        if (mlog::gzipFile(filePath(name), partPath, level, interrupted) == false) {
+            QFile::remove(partPath);
+            // Failed files are retried on next call
+            const bool wasInterrupted = interrupted && interrupted();
+            return wasInterrupted == false;
+        }
+
+        moveFile(partPath, filePath(compressedName));
+        QFile::remove(filePath(name));
+        manifest.logs[i] = compressedName;
+        writeManifest(manifest);
+    }
+    return true;
+}
+
+/*!
+ * Returns rotation set from the manifest, or from a directory scan if the
+ * manifest can not be used.
+ */
+MLogRotation::Manifest MLogRotation::loadManifest() const
+{
+    Manifest manifest;
+    if (readManifest(manifest))
+        return manifest;
+    return scanDirectory();
+}
+
+/*!
+ * Reads the manifest into \a manifest. Returns false if it is missing,
+ * corrupt, describes a different rotation type or lists logs which no longer
+ * exist.
+ */
+bool MLogRotation::readManifest(Manifest &manifest) const
+{
+    QFile file(manifestPath());
+    if (file.open(QFile::ReadOnly) == false)
+        return false;
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || document.isObject() == false)
+        return false;
+
+    const QJsonObject object = document.object();
+    if (object.value(QStringLiteral("version")).toInt() != manifestVersion
+            || object.value(QStringLiteral("rotation")).toString() != rotationName(m_type)) {
+        return false;
+    }
+
+    manifest.current = object.value(QStringLiteral("current")).toString();
+    manifest.logs.clear();
+    const QJsonArray logs = object.value(QStringLiteral("logs")).toArray();
+    for (const QJsonValue &value : logs) {
+        const QString name = value.toString();
+        if (name.isEmpty() || QFileInfo::exists(filePath(name)) == false)
+            return false;
+        manifest.logs.append(name);
+    }
+    return true;
+}
+
+/*!
+ * Rebuilds rotation set by matching all files in the log directory.
+ */
+MLogRotation::Manifest MLogRotation::scanDirectory() const
+{
+    const QDir logsDir(m_directory);
+    const QString logFilter(m_appName + QLatin1String("-*") + QLatin1String(fileExt));
+    const QStringList files = logsDir.entryList(
+                { logFilter, QString(logFilter + QLatin1String(compressedExt)) },
+                QDir::Files);
+    const QString appName = QRegularExpression::escape(m_appName);
+
+    Manifest manifest;
+    if (m_type == MLog::RotationType::Consequent) {
+        const QRegularExpression expr(
+                    QString('^' + appName + QLatin1String("-previous(-([1-9][0-9]*))?\\.log(\\.gz)?$")));
+        QVector<QPair<int, QString>> previous;
+        for (const QString &file : files) {
+            const QRegularExpressionMatch match = expr.match(file);
+            if (match.hasMatch())
+                previous.append(qMakePair(match.captured(2).toInt(), file));
+        }
+
+        // Plain log sorts before its compressed copy (left behind if
+        // compression was interrupted), which is then skipped
+        std::sort(previous.begin(), previous.end());
+        int lastIndex = -1;
+        for (const auto &log : qAsConst(previous)) {
+            if (log.first != lastIndex)
+                manifest.logs.append(log.second);
+            lastIndex = log.first;
+        }
+    } else {
+        const QRegularExpression expr(
+                    QString('^' + appName + QLatin1String(
+                                "-\\d\\d\\d\\d-\\d\\d-\\d\\d_\\d\\d-\\d\\d-\\d\\d\\.log(\\.gz)?$")));
+        for (const QString &file : files) {
+            if (expr.match(file).hasMatch())
+                manifest.logs.append(file);
+        }
+
+        // Names sort chronologically, newest go first
+        std::sort(manifest.logs.begin(), manifest.logs.end(), std::greater<QString>());
+    }
+    return manifest;
+}
+
+/*!
+ * Returns paths of logs renamed by rotatedLogPath() which are still waiting
+ * to be moved into the rotation set, oldest first.
+ */
+QStringList MLogRotation::pendingRotatedLogs() const
+{
+    const QDir logsDir(m_directory);
+    const QStringList files = logsDir.entryList(
+                { QString(m_appName + QLatin1String("-rotated-*") + QLatin1String(fileExt)) },
+                QDir::Files);
+    const QRegularExpression expr(
+                QString('^' + QRegularExpression::escape(m_appName)
+                        + QLatin1String("-rotated-(\\d+)-(\\d+)\\.log$")));
+
+    // Ordered by rotation time, then by rotation count within the same run
+    QVector<QPair<QPair<qint64, quint64>, QString>> rotated;
+    for (const QString &file : files) {
+        const QRegularExpressionMatch match = expr.match(file);
+        if (match.hasMatch()) {
+            rotated.append(qMakePair(qMakePair(match.captured(1).toLongLong(),
+                                               match.captured(2).toULongLong()),
+                                     file));
+        }
+    }
+    std::sort(rotated.begin(), rotated.end());
+
+    QStringList paths;
+    for (const auto &log : qAsConst(rotated))
+        paths.append(filePath(log.second));
+    return paths;
+}
+
+/*!
+ * Atomically replaces the manifest with \a manifest.
+ */
+void MLogRotation::writeManifest(const Manifest &manifest) const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("version"), manifestVersion);
+    object.insert(QStringLiteral("rotation"), rotationName(m_type));
+    object.insert(QStringLiteral("current"), manifest.current);
+    object.insert(QStringLiteral("logs"), QJsonArray::fromStringList(manifest.logs));
+
+    QSaveFile file(manifestPath());
+    if (file.open(QFile::WriteOnly)) {
+        file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+/*!
+ * Puts \a closedLogPath at the front of rotation set \a manifest. Consequent
+ * logs are shifted (previous -> previous-1 ...) first, logs which would fall
+ * out of the set are removed instead of being renamed.
+ */
+void MLogRotation::addClosedLog(Manifest &manifest, const QString &closedLogPath) const
+{
+    if (closedLogPath.isEmpty() || QFileInfo::exists(closedLogPath) == false)
+        return;
+
+    if (m_type == MLog::RotationType::DateTime) {
+        const QString name = QFileInfo(closedLogPath).fileName();
+        manifest.logs.removeAll(name);
+        manifest.logs.prepend(name);
+        return;
+    }
+
+    const int maxLogs = maxPreviousLogs();
+    while (manifest.logs.size() >= maxLogs)
+        QFile::remove(filePath(manifest.logs.takeLast()));
+
+    // Start from the oldest one, so that no file is overwritten
+    for (int i = manifest.logs.size() - 1; i >= 0; --i) {
+        QString name = previousLogName(i + 1);
+        if (manifest.logs.at(i).endsWith(QLatin1String(compressedExt)))
+            name += QLatin1String(compressedExt);
+        moveFile(filePath(manifest.logs.at(i)), filePath(name));
+        manifest.logs[i] = name;
+    }
+
+    const QString name = previousLogName(0);
+    moveFile(closedLogPath, filePath(name));
+    manifest.logs.prepend(name);
+}
+
+/*!
+ * Removes oldest logs from \a manifest (and disk) until it fits the limit.
+ */
+void MLogRotation::removeExcessLogs(Manifest &manifest) const
+{
+    const int maxLogs = maxPreviousLogs();
+    while (manifest.logs.size() > maxLogs)
+        QFile::remove(filePath(manifest.logs.takeLast()));
+}
+
+/*!
+ * Returns name of Consequent log number \a index: previous log for 0,
+ * previous-1 for 1 and so on.
+ */
+QString MLogRotation::previousLogName(const int index) const
+{
+    if (index == 0)
+        return QString(m_appName + QLatin1String("-previous") + QLatin1String(fileExt));
+    return QString(m_appName + QLatin1String("-previous-") + QString::number(index)
+                   + QLatin1String(fileExt));
+}
+
+QString MLogRotation::filePath(const QString &fileName) const
+{
+    return QString(m_directory + '/' + fileName);
+}
+
+/*!
+ * Returns number of logs kept besides the current one. Previous log is always
+ * kept.
+ */
+int MLogRotation::maxPreviousLogs() const
+{
+    return qMax(m_maxLogs - 1, 1);
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+#include "mlog.h"
+
+/*!
+ * \internal
+ * Rotation set of one application's logs: naming of log files, moving the
+ * closed log into the set and removing logs above the limit.
+ *
+ * The set is described by a small manifest file kept next to the logs, so
+ * rotation does not have to list and match the whole log directory. The
+ * manifest is rebuilt from a directory scan when it is missing, corrupt or
+ * out of date.
+ *
+ * Logs which left the current slot can be gzip compressed, compressed logs
+ * keep their place in the set and get ".gz" appended to their names.
+ *
+ * Instances are cheap value objects, they can be copied into tasks run by
+ * MLogWorker.
+ */
+class MLogRotation
+{
+public:
+    MLogRotation(const QString &directory, const QString &appName,
+                 const MLog::RotationType type, const int maxLogs);
+
+    QString currentLogPath(const qint64 timestamp) const;
+    QString rotatedLogPath(const qint64 timestamp, const quint64 count) const;
+    QString previousLogPath() const;
+    QString manifestPath() const;
+
+    QString startup(const QString &currentLogPath,
+                    const QString &closedLogPath) const;
+    void rotate(const QString &closedLogPath, const QString &currentLogPath) const;
+    bool compress(const int level, const std::function<bool()> &interrupted) const;
+
+private:
+    struct Manifest {
+        //! Name of the log file being written
+        QString current;
+        //! Names of older logs, newest first
+        QStringList logs;
+    };
+
+    Manifest loadManifest() const;
+    bool readManifest(Manifest &manifest) const;
+    Manifest scanDirectory() const;
+    QStringList pendingRotatedLogs() const;
+    void writeManifest(const Manifest &manifest) const;
+    void addClosedLog(Manifest &manifest, const QString &closedLogPath) const;
+    void removeExcessLogs(Manifest &manifest) const;
+    QString previousLogName(const int index) const;
+    QString filePath(const QString &fileName) const;
+    int maxPreviousLogs() const;
+
+    QString m_directory;
+    QString m_appName;
+    MLog::RotationType m_type = MLog::RotationType::Consequent;
+    int m_maxLogs = 2;
+};
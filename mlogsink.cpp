@@ -0,0 +1,344 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogsink.h"
+#include "mlogformatter.h"
+
+#include <cstdio>
+
+#ifdef ANDROID
+#include <android/log.h>
+#endif
+
+/*!
+ * \class MLogSink
+ * \brief Base class of log outputs
+ *
+ * \sa MLog::addSink
+ */
+
+MLogSink::MLogSink()
+{
+}
+
+MLogSink::~MLogSink()
+{
+}
+
+/*!
+ * Sets log level of this sink to \a level. Messages above it are not written
+ * into this sink, other outputs are not affected. Default is MLog::DebugLog,
+ * which means that the sink gets all messages which pass MLog::logLevel()
+ * and MLog::setCategoryLogLevels().
+ */
+void MLogSink::setLogLevel(const MLog::LogLevel level)
+{
+    m_logLevel.store(level, std::memory_order_relaxed);
+}
+
+/*!
+ * Returns log level of this sink.
+ *
+ * \sa setLogLevel
+ */
+MLog::LogLevel MLogSink::logLevel() const
+{
+    return m_logLevel.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Returns true if messages of \a type pass log level of this sink.
+ */
+bool MLogSink::isMessageAllowed(const QtMsgType type) const
+{
+    MLog::LogLevel level = MLog::DebugLog;
+    switch (type) {
+    case QtDebugMsg:
+        level = MLog::DebugLog;
+        break;
+    case QtInfoMsg:
+        level = MLog::InfoLog;
+        break;
+    case QtWarningMsg:
+        level = MLog::WarningLog;
+        break;
+    case QtCriticalMsg:
+        level = MLog::CriticalLog;
+        break;
+    case QtFatalMsg:
+        level = MLog::FatalLog;
+        break;
+    }
+    return level <= logLevel();
+}
+
+/*!
+ * Sets message \a pattern used by this sink, see MLog::setMessagePattern()
+ * for syntax. Empty \a pattern (default) means MLog's own pattern.
+ */
+void MLogSink::setMessagePattern(const QString &pattern)
+{
+    m_formatter.store(pattern.isEmpty() ? nullptr : MLogFormatter::shared(pattern),
+                      std::memory_order_release);
+}
+
+/*!
+ * Returns message pattern of this sink, or an empty string if it uses MLog's
+ * pattern.
+ *
+ * \sa setMessagePattern
+ */
+QString MLogSink::messagePattern() const
+{
+    const MLogFormatter *formatter = this->formatter();
+    return formatter ? formatter->pattern() : QString();
+}
+
+/*!
+ * Writes out all messages buffered by the sink. Sinks which do not buffer
+ * anything ignore it.
+ */
+void MLogSink::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    writePending();
+}
+
+/*!
+ * Called by MLog, writes \a line of \a type with the sink locked.
+ */
+void MLogSink::output(const QtMsgType type, const QByteArray &line)
+{
+    QMutexLocker locker(&m_mutex);
+    write(type, line);
+}
+
+/*!
+ * Returns formatter of this sink, or nullptr if it uses MLog's pattern.
+ */
+const MLogFormatter *MLogSink::formatter() const
+{
+    return m_formatter.load(std::memory_order_acquire);
+}
+
+/*!
+ * \class MLogConsoleSink
+ * \brief Sink writing into stderr or Android logcat
+ */
+
+//! Buffered console output is written out when it grows this big
+static const int sMaxConsoleBuffer = 64 * 1024;
+//! How long buffered lines wait at most with LineCount and Severity policies
+static const int sConsoleFlushDelay = 1000;
+
+/*!
+ * Sets flush \a policy of this sink. \a threshold is the number of lines for
+ * MLog::ConsoleFlushPolicy::LineCount and the number of milliseconds for
+ * MLog::ConsoleFlushPolicy::Interval; it is ignored by other policies.
+ * Pending output is written out first.
+ *
+ * \sa MLog::setConsoleFlushPolicy
+ */
+void MLogConsoleSink::setFlushPolicy(const MLog::ConsoleFlushPolicy policy,
+                                     const int threshold)
+{
+    flush();
+    m_threshold.store(threshold, std::memory_order_relaxed);
+    m_policy.store(policy, std::memory_order_relaxed);
+}
+
+/*!
+ * Returns flush policy of this sink.
+ *
+ * \sa setFlushPolicy
+ */
+MLog::ConsoleFlushPolicy MLogConsoleSink::flushPolicy() const
+{
+    return m_policy.load(std::memory_order_relaxed);
+}
+
+void MLogConsoleSink::write(const QtMsgType type, const QByteArray &line)
+{
+#ifndef ANDROID
+    const MLog::ConsoleFlushPolicy policy = flushPolicy();
+    if (policy == MLog::ConsoleFlushPolicy::Immediate && m_buffer.isEmpty()) {
+        fwrite(line.constData(), 1, size_t(line.size()), stderr);
+        fflush(stderr);
+        return;
+    }
+
+    const int threshold = m_threshold.load(std::memory_order_relaxed);
+    const int delay = policy == MLog::ConsoleFlushPolicy::Interval ? threshold
+                                                                  : sConsoleFlushDelay;
+    if (m_buffer.isEmpty()) {
+        m_pendingTimer.start();
+        if (m_scheduleFlush && delay > 0)
+            m_scheduleFlush(delay);
+    }
+    m_buffer.append(line);
+    ++m_pendingLines;
+
+    bool flushNow = type == QtFatalMsg || m_buffer.size() >= sMaxConsoleBuffer
+            || m_pendingTimer.hasExpired(delay);
+    switch (policy) {
+    case MLog::ConsoleFlushPolicy::Immediate:
+        flushNow = true;
+        break;
+    case MLog::ConsoleFlushPolicy::LineCount:
+        flushNow = flushNow || m_pendingLines >= threshold;
+        break;
+    case MLog::ConsoleFlushPolicy::Interval:
+        flushNow = flushNow || threshold <= 0;
+        break;
+    case MLog::ConsoleFlushPolicy::Severity:
+        flushNow = flushNow || type == QtWarningMsg || type == QtCriticalMsg;
+        break;
+    }
+
+    if (flushNow)
+        writePending();
+#else
+    android_LogPriority priority = ANDROID_LOG_DEBUG;
+    switch (type) {
+        case QtWarningMsg: priority = ANDROID_LOG_WARN; break;
+        case QtCriticalMsg: priority = ANDROID_LOG_ERROR; break;
+        case QtFatalMsg: priority = ANDROID_LOG_FATAL; break;
+        case QtInfoMsg: priority = ANDROID_LOG_INFO; break;
+        default: priority = ANDROID_LOG_DEBUG; break;
+    };
+    // logcat adds its own newline
+    int size = line.size();
+    if (size > 0 && line.at(size - 1) == '\n')
+        --size;
+    __android_log_print(priority, "Qt", "%.*s", size, line.constData());
+#endif
+}
+
+void MLogConsoleSink::writePending()
+{
+    if (m_buffer.isEmpty())
+        return;
+
+    fwrite(m_buffer.constData(), 1, size_t(m_buffer.size()), stderr);
+    fflush(stderr);
+    // Keep the capacity for next messages
+    m_buffer.resize(0);
+    m_pendingLines = 0;
+    m_pendingTimer.invalidate();
+}
+
+/*!
+ * \class MLogFileSink
+ * \brief Sink appending messages to a file
+ */
+
+/*!
+ * Opens file at \a path for appending. Check isOpen() to see if it worked.
+ */
+MLogFileSink::MLogFileSink(const QString &path)
+    : m_file(path)
+{
+    m_file.open(QFile::WriteOnly | QFile::Append | QFile::Text);
+}
+
+/*!
+ * Returns path of the file.
+ */
+QString MLogFileSink::path() const
+{
+    return m_file.fileName();
+}
+
+/*!
+ * Returns true if the file could be opened.
+ */
+bool MLogFileSink::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void MLogFileSink::write(const QtMsgType type, const QByteArray &line)
+{
+    Q_UNUSED(type)
+    if (m_file.isOpen()) {
+        m_file.write(line);
+        m_file.flush();
+    }
+}
+
+/*!
+ * \class MLogMemorySink
+ * \brief Sink keeping last messages in memory
+ */
+
+/*!
+ * Creates sink which keeps \a capacity last messages.
+ */
+MLogMemorySink::MLogMemorySink(const int capacity)
+    : m_capacity(qMax(capacity, 1))
+{
+}
+
+/*!
+ * Returns kept messages, oldest first, without trailing newlines.
+ */
+QStringList MLogMemorySink::lines() const
+{
+    QMutexLocker locker(&m_linesMutex);
+    QStringList result;
+    result.reserve(m_lines.size());
+    for (int i = 0; i < m_lines.size(); ++i) {
+        const QByteArray &line = m_lines.at((m_next + i) % m_lines.size());
+        result.append(QString::fromUtf8(line.endsWith('\n') ? line.left(line.size() - 1)
+                                                            : line));
+    }
+    return result;
+}
+
+/*!
+ * Removes all kept messages.
+ */
+void MLogMemorySink::clear()
+{
+    QMutexLocker locker(&m_linesMutex);
+    m_lines.clear();
+    m_next = 0;
+}
+
+void MLogMemorySink::write(const QtMsgType type, const QByteArray &line)
+{
+    Q_UNUSED(type)
+    QMutexLocker locker(&m_linesMutex);
+    if (m_lines.size() < m_capacity) {
+        m_lines.append(line);
+        // line is only valid during this call
+        m_lines.last().detach();
+        return;
+    }
+
+    // Reuse buffer of the oldest line
+    QByteArray &oldest = m_lines[m_next];
+    oldest.resize(0);
+    oldest.append(line);
+    m_next = (m_next + 1) % m_capacity;
+}
@@ -0,0 +1,162 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+#include "mlog.h"
+
+/*!
+ * Output for log messages. MLog writes into its log file and the console by
+ * itself, any number of additional sinks can be attached with MLog::addSink().
+ *
+ * Every sink has its own log level (on top of MLog's global and per-category
+ * levels) and, optionally, its own message pattern. Messages are formatted
+ * once per distinct pattern and shared between all sinks using it.
+ *
+ * To write a custom sink, subclass MLogSink and implement write(). MLog
+ * serializes calls to write() of a single sink, so it does not need its own
+ * locking.
+ */
+class MLogSink
+{
+public:
+    MLogSink();
+    virtual ~MLogSink();
+
+    void setLogLevel(const MLog::LogLevel level);
+    MLog::LogLevel logLevel() const;
+    bool isMessageAllowed(const QtMsgType type) const;
+
+    void setMessagePattern(const QString &pattern);
+    QString messagePattern() const;
+
+    void flush();
+
+protected:
+    /*!
+     * Writes a single message of \a type. \a line is UTF-8 encoded, formatted
+     * according to the message pattern and ends with a newline. Messages
+     * written with MLog::writeRaw() are passed exactly as given.
+     *
+     * \a line only stays valid until this function returns.
+     */
+    virtual void write(const QtMsgType type, const QByteArray &line) = 0;
+
+    /*!
+     * Writes out anything the sink buffers. Called by flush(), which MLog
+     * calls from MLog::flush() and before qFatal() aborts the application.
+     */
+    virtual void writePending() {}
+
+private:
+    Q_DISABLE_COPY(MLogSink)
+    friend class MLog;
+
+    void output(const QtMsgType type, const QByteArray &line);
+    const MLogFormatter *formatter() const;
+
+    QMutex m_mutex;
+    std::atomic<MLog::LogLevel> m_logLevel{MLog::DebugLog};
+    //! Null means MLog's own message pattern
+    std::atomic<const MLogFormatter *> m_formatter{nullptr};
+};
+
+/*!
+ * Writes messages into stderr (or Android logcat). This is what MLog uses
+ * for its own console output, see MLog::enableLogToConsole() and
+ * MLog::setConsoleFlushPolicy().
+ */
+class MLogConsoleSink : public MLogSink
+{
+public:
+    void setFlushPolicy(const MLog::ConsoleFlushPolicy policy, const int threshold = 0);
+    MLog::ConsoleFlushPolicy flushPolicy() const;
+
+protected:
+    void write(const QtMsgType type, const QByteArray &line) override;
+    void writePending() override;
+
+private:
+    friend class MLog;
+
+    std::atomic<MLog::ConsoleFlushPolicy> m_policy{MLog::ConsoleFlushPolicy::Immediate};
+    std::atomic<int> m_threshold{0};
+    QByteArray m_buffer;
+    int m_pendingLines = 0;
+    //! Started when the oldest pending line was buffered
+    QElapsedTimer m_pendingTimer;
+    //! Set by MLog, schedules flush() in given number of milliseconds
+    std::function<void(int)> m_scheduleFlush;
+};
+
+/*!
+ * Appends messages to a file. Unlike MLog::enableLogToFile(), the file is
+ * neither rotated nor compressed.
+ */
+class MLogFileSink : public MLogSink
+{
+public:
+    explicit MLogFileSink(const QString &path);
+
+    QString path() const;
+    bool isOpen() const;
+
+protected:
+    void write(const QtMsgType type, const QByteArray &line) override;
+
+private:
+    QFile m_file;
+};
+
+/*!
+ * Keeps the last few messages in memory, for example to show them in the
+ * application or to attach them to a crash report.
+ */
+class MLogMemorySink : public MLogSink
+{
+public:
+    explicit MLogMemorySink(const int capacity = 1000);
+
+    QStringList lines() const;
+    void clear();
+
+protected:
+    void write(const QtMsgType type, const QByteArray &line) override;
+
+private:
+    mutable QMutex m_linesMutex;
+    QVector<QByteArray> m_lines;
+    int m_capacity = 0;
+    //! Index of the oldest line, once m_lines is full
+    int m_next = 0;
+};
@@ -0,0 +1,177 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogstaging.h"
+
+#include <QMutexLocker>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+//! Keeps buffer of the current thread alive and marks it orphaned when the
+//! thread exits
+template <typename Buffer>
+struct ThreadBuffer
+{
+    QSharedPointer<Buffer> buffer;
+
+    ~ThreadBuffer()
+    {
+        if (buffer)
+            buffer->orphaned.store(true, std::memory_order_release);
+    }
+};
+
+}
+
+/*!
+ * \class MLogStaging
+ * \internal
+ * \brief Per-thread buffers for log file lines
+ */
+
+/*!
+ * Appends formatted \a line (in log file \a format, logged at \a timestamp)
+ * to the buffer of the calling thread. Returns true if the buffer holds
+ * \a limit bytes or more, which means it should be handed off now.
+ */
+bool MLogStaging::append(const QByteArray &line, const MLog::FileFormat format,
+                         const qint64 timestamp, const int limit)
+{
+    Buffer *buffer = threadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    Line entry;
+    entry.sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
+    entry.timestamp = timestamp;
+    entry.offset = buffer->data.size();
+    entry.size = line.size();
+    entry.format = format;
+    buffer->data.append(line);
+    buffer->lines.append(entry);
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    return buffer->data.size() >= limit;
+}
+
+/*!
+ * Returns true if there are no staged lines.
+ */
+bool MLogStaging::isEmpty() const
+{
+    return m_pending.load(std::memory_order_relaxed) == 0;
+}
+
+/*!
+ * Takes all staged lines out of the buffers and merges them in the order in
+ * which they were logged. Result is available through takenData() and
+ * takenLines(), until the next call.
+ *
+ * Every buffer is locked only for as long as it takes to swap its contents
+ * out, so logging threads do not wait for the merge. Buffers of threads
+ * which exited are released once they are empty.
+ */
+void MLogStaging::take()
+{
+    if (m_takenData.capacity() == 0)
+        m_takenData.reserve(65536);
+    m_takenData.resize(0);
+    m_takenLines.resize(0);
+
+    QMutexLocker buffersLocker(&m_buffersMutex);
+    int taken = 0;
+    for (const QSharedPointer<Buffer> &buffer : qAsConst(m_buffers)) {
+        QMutexLocker locker(&buffer->mutex);
+        qSwap(buffer->data, buffer->takenData);
+        qSwap(buffer->lines, buffer->takenLines);
+        taken += buffer->takenLines.size();
+    }
+    m_pending.fetch_sub(taken, std::memory_order_relaxed);
+
+    // Lines of every buffer are already in order, merge the runs. There are
+    // as many runs as logging threads, so a linear scan for the next line is
+    // good enough
+    QVarLengthArray<int, 16> next(m_buffers.size());
+    std::fill(next.begin(), next.end(), 0);
+    for (int i = 0; i < taken; ++i) {
+        int run = -1;
+        quint64 sequence = std::numeric_limits<quint64>::max();
+        for (int b = 0; b < m_buffers.size(); ++b) {
+            const QVector<Line> &runLines = m_buffers.at(b)->takenLines;
+            if (next[b] < runLines.size() && runLines.at(next[b]).sequence <= sequence) {
+                run = b;
+                sequence = runLines.at(next[b]).sequence;
+            }
+        }
+
+        const Buffer &buffer = *m_buffers.at(run);
+        Line line = buffer.takenLines.at(next[run]++);
+        const int offset = m_takenData.size();
+        m_takenData.append(buffer.takenData.constData() + line.offset, line.size);
+        line.offset = offset;
+        m_takenLines.append(line);
+    }
+
+    for (int b = m_buffers.size() - 1; b >= 0; --b) {
+        Buffer &buffer = *m_buffers.at(b);
+        buffer.takenData.resize(0);
+        buffer.takenLines.resize(0);
+        // Owner exited, so nothing was appended since the swap
+        if (buffer.orphaned.load(std::memory_order_acquire) && buffer.lines.isEmpty())
+            m_buffers.remove(b);
+    }
+}
+
+/*!
+ * Returns text of lines collected by the last take().
+ */
+const QByteArray &MLogStaging::takenData() const
+{
+    return m_takenData;
+}
+
+/*!
+ * Returns lines collected by the last take(), in the order in which they were
+ * logged. Offsets point into takenData().
+ */
+const QVector<MLogStaging::Line> &MLogStaging::takenLines() const
+{
+    return m_takenLines;
+}
+
+/*!
+ * Returns buffer of the calling thread, registering it on first use.
+ */
+MLogStaging::Buffer *MLogStaging::threadBuffer()
+{
+    static thread_local ThreadBuffer<Buffer> sBuffer;
+    if (sBuffer.buffer.isNull()) {
+        sBuffer.buffer = QSharedPointer<Buffer>::create();
+        sBuffer.buffer->data.reserve(4096);
+        sBuffer.buffer->takenData.reserve(4096);
+        QMutexLocker locker(&m_buffersMutex);
+        m_buffers.append(sBuffer.buffer);
+    }
+    return sBuffer.buffer.data();
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <atomic>
+
+#include "mlog.h"
+
+/*!
+ * \internal
+ * Per-thread staging buffers for log file lines, see
+ * MLog::enableThreadBuffering().
+ *
+ * Every logging thread appends its formatted lines to a buffer of its own,
+ * guarded by a mutex which only the owner and take() ever lock, so it is
+ * practically never contended. Each line gets a number from a global
+ * sequence; take() merges lines of all buffers back in that order. MLog calls
+ * take() only with its file lock held.
+ *
+ * There is one instance per process (owned by MLog).
+ */
+class MLogStaging
+{
+public:
+    //! A line collected by take()
+    struct Line
+    {
+        quint64 sequence = 0;
+        qint64 timestamp = 0;
+        int offset = 0;
+        int size = 0;
+        MLog::FileFormat format = MLog::FileFormat::Text;
+    };
+
+    MLogStaging() = default;
+
+    bool append(const QByteArray &line, const MLog::FileFormat format,
+                const qint64 timestamp, const int limit);
+    bool isEmpty() const;
+    void take();
+    const QByteArray &takenData() const;
+    const QVector<Line> &takenLines() const;
+
+private:
+    Q_DISABLE_COPY(MLogStaging)
+
+    struct Buffer
+    {
+        QMutex mutex;
+        QByteArray data;
+        QVector<Line> lines;
+        //! Lines taken out of the buffer by take(), being merged
+        QByteArray takenData;
+        QVector<Line> takenLines;
+        //! Set when owning thread exits
+        std::atomic<bool> orphaned{false};
+    };
+
+    Buffer *threadBuffer();
+
+    //! Guards m_buffers
+    QMutex m_buffersMutex;
+    QVector<QSharedPointer<Buffer>> m_buffers;
+    std::atomic<quint64> m_sequence{0};
+    //! Lines staged and not taken yet
+    std::atomic<int> m_pending{0};
+    //! Result of the last take()
+    QByteArray m_takenData;
+    QVector<Line> m_takenLines;
+};
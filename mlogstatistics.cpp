@@ -0,0 +1,176 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogstatistics.h"
+#include "mlogcategorylevels.h"
+
+#include <QJsonArray>
+
+namespace {
+
+const char *levelNames[] = { "none", "fatal", "critical", "warning", "info", "debug" };
+
+//! Returns shard of the calling thread
+int currentShard(const int shardCount)
+{
+    static std::atomic<int> sNextShard{0};
+    static thread_local int sShard = sNextShard.fetch_add(1, std::memory_order_relaxed);
+    return sShard % shardCount;
+}
+
+}
+
+/*!
+ * \class MLogStatistics
+ * \brief Counters of messages handled by MLog
+ *
+ * \sa MLog::statistics
+ */
+
+/*!
+ * Returns number of all logged messages.
+ */
+quint64 MLogStatistics::totalMessages() const
+{
+    quint64 total = 0;
+    for (const quint64 count : messages)
+        total += count;
+    return total;
+}
+
+/*!
+ * Returns statistics as a JSON object, ready to be exported to a monitoring
+ * system:
+ * \code
+ * {
+ *     "messages": { "debug": 120, "info": 14, ... },
+ *     "categories": { "default": 130, "net": 4 },
+ *     "bytesWritten": 10240, "rejected": 0, "suppressed": 0, "dropped": 0,
+ *     "queueDepth": 0, "writeLatency": [ 80, 50, 4, 0, ... ]
+ * }
+ * \endcode
+ */
+QJsonObject MLogStatistics::toJson() const
+{
+    QJsonObject levels;
+    for (int level = MLog::FatalLog; level <= MLog::DebugLog; ++level)
+        levels.insert(QLatin1String(levelNames[level]), double(messages[level]));
+
+    QJsonObject categories;
+    for (auto it = this->categories.cbegin(); it != this->categories.cend(); ++it)
+        categories.insert(it.key(), double(it.value()));
+
+    QJsonArray latency;
+    for (const quint64 count : writeLatency)
+        latency.append(double(count));
+
+    QJsonObject result;
+    result.insert(QStringLiteral("messages"), levels);
+    result.insert(QStringLiteral("categories"), categories);
+    result.insert(QStringLiteral("bytesWritten"), double(bytesWritten));
+    result.insert(QStringLiteral("rejected"), double(rejected));
+    result.insert(QStringLiteral("suppressed"), double(suppressed));
+    result.insert(QStringLiteral("dropped"), double(dropped));
+    result.insert(QStringLiteral("queueDepth"), double(queueDepth));
+    result.insert(QStringLiteral("writeLatency"), latency);
+    return result;
+}
+
+/*!
+ * \class MLogStatisticsCounters
+ * \internal
+ * \brief Sharded counters of MLog statistics
+ */
+
+MLogStatisticsCounters::Shard::Shard()
+{
+    for (std::atomic<quint64> &value : values)
+        value.store(0, std::memory_order_relaxed);
+}
+
+/*!
+ * Counts a logged message of \a type.
+ */
+void MLogStatisticsCounters::addMessage(const QtMsgType type)
+{
+    counter(Messages + MLogCategoryLevels::messageLevel(type))
+            .fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ * Counts a message rejected by MLog.
+ */
+void MLogStatisticsCounters::addRejected()
+{
+    counter(Rejected).fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ * Adds a message written in \a nanoseconds to the latency histogram.
+ */
+void MLogStatisticsCounters::addLatency(const qint64 nanoseconds)
+{
+    quint64 microseconds = nanoseconds > 0 ? quint64(nanoseconds) / 1000 : 0;
+    int bucket = 0;
+    while (microseconds > 0 && bucket < MLogStatistics::LatencyBuckets - 1) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+    counter(Latency + bucket).fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ * Adds counters of all shards into \a statistics.
+ */
+void MLogStatisticsCounters::collect(MLogStatistics &statistics) const
+{
+    statistics.writeLatency.fill(0, MLogStatistics::LatencyBuckets);
+    for (const Shard &shard : m_shards) {
+        for (int level = MLog::NoLog; level <= MLog::DebugLog; ++level)
+            statistics.messages[level] += shard.values[Messages + level].load(std::memory_order_relaxed);
+        statistics.rejected += shard.values[Rejected].load(std::memory_order_relaxed);
+        for (int bucket = 0; bucket < MLogStatistics::LatencyBuckets; ++bucket) {
+            statistics.writeLatency[bucket]
+                    += shard.values[Latency + bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/*!
+ * Sets all counters to 0.
+ */
+void MLogStatisticsCounters::reset()
+{
+    for (Shard &shard : m_shards) {
+        for (std::atomic<quint64> &value : shard.values)
+            value.store(0, std::memory_order_relaxed);
+    }
+}
+
+/*!
+ * Returns \a counter in the shard of the calling thread.
+ */
+std::atomic<quint64> &MLogStatisticsCounters::counter(const int counter)
+{
+    return m_shards[currentShard(ShardCount)].values[counter];
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+#include "mlog.h"
+
+/*!
+ * Snapshot of MLog's own statistics, see MLog::statistics().
+ */
+struct MLogStatistics
+{
+    //! Number of buckets in writeLatency
+    static const int LatencyBuckets = 21;
+
+    //! Messages logged, indexed by MLog::LogLevel (NoLog is always 0)
+    quint64 messages[MLog::DebugLog + 1] = {};
+    //! Messages logged, by category name
+    QMap<QString, quint64> categories;
+    //! Bytes written into log files
+    quint64 bytesWritten = 0;
+    //! Messages which reached MLog, but were rejected by log level (while
+    //! flight recorder is enabled) or by sampling
+    quint64 rejected = 0;
+    //! Messages dropped by rate limit, see MLog::enableRateLimit()
+    quint64 suppressed = 0;
+    //! Messages dropped because asynchronous queue was full
+    quint64 dropped = 0;
+    //! Messages waiting in asynchronous queue
+    quint64 queueDepth = 0;
+    //! Time needed to write a message into all outputs: bucket \c i counts
+    //! messages written in less than 2^i microseconds, the last one all
+    //! slower messages
+    QVector<quint64> writeLatency;
+
+    quint64 totalMessages() const;
+    QJsonObject toJson() const;
+};
+
+/*!
+ * Messages logged from a single call site, see MLog::topCallSites().
+ */
+struct MLogCallSiteStatistics
+{
+    QString file;
+    int line = 0;
+    QString function;
+    QString category;
+    quint64 messages = 0;
+    //! Bytes of message text encoded as UTF-8 (not including message pattern)
+    quint64 size = 0;
+};
+
+/*!
+ * \internal
+ * Counters behind MLogStatistics. Every counter is sharded: each thread
+ * increments its own cache line, so counting does not add contention.
+ * Shards are summed only when a snapshot is taken.
+ */
+class MLogStatisticsCounters
+{
+public:
+    enum Counter {
+        Messages, //!< Followed by one counter per MLog::LogLevel
+        Rejected = Messages + MLog::DebugLog + 1,
+        Latency, //!< Followed by LatencyBuckets counters
+        CounterCount = Latency + MLogStatistics::LatencyBuckets
+    };
+
+    void addMessage(const QtMsgType type);
+    void addRejected();
+    void addLatency(const qint64 nanoseconds);
+
+    void collect(MLogStatistics &statistics) const;
+    void reset();
+
+private:
+    static const int ShardCount = 16;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<quint64> values[CounterCount];
+
+        Shard();
+    };
+
+    std::atomic<quint64> &counter(const int counter);
+
+    Shard m_shards[ShardCount];
+};
@@ -0,0 +1,102 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogstorage.h"
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * \class MLogStorage
+ * \brief Durability helpers for the log file
+ */
+
+/*!
+ * Makes data already written into \a file durable, so that it survives a
+ * crash of the whole system. Only file data is synchronized (fdatasync()
+ * where available), not metadata which is not needed to read it back.
+ *
+ * Returns false if \a file is not open or the system call failed.
+ */
+bool MLogStorage::sync(QFile &file)
+{
+    const int handle = file.handle();
+    if (handle < 0)
+        return false;
+
+#if defined(Q_OS_WIN)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(handle))) != 0;
+#elif defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+    return fdatasync(handle) == 0;
+#elif defined(Q_OS_UNIX)
+    return fsync(handle) == 0;
+#else
+    return file.flush();
+#endif
+}
+
+/*!
+ * Allocates disk space for \a length bytes of \a file starting at \a offset,
+ * without changing its size. Writes into preallocated space do not have to
+ * update file system metadata (block allocation) every time.
+ *
+ * Returns false if preallocation is not supported by the platform or file
+ * system, which is harmless - the file simply grows as before.
+ *
+ * \sa trim
+ */
+bool MLogStorage::preallocate(QFile &file, const qint64 offset, const qint64 length)
+{
+#if defined(Q_OS_LINUX) && defined(FALLOC_FL_KEEP_SIZE)
+    const int handle = file.handle();
+    if (handle < 0 || length <= 0)
+        return false;
+
+    // File is opened with O_APPEND, its size must stay where the data ends
+    return fallocate(handle, FALLOC_FL_KEEP_SIZE, offset, length) == 0;
+#else
+    Q_UNUSED(file)
+    Q_UNUSED(offset)
+    Q_UNUSED(length)
+    return false;
+#endif
+}
+
+/*!
+ * Truncates \a file to \a size bytes, which also releases disk space
+ * preallocated beyond it.
+ *
+ * \sa preallocate
+ */
+bool MLogStorage::trim(QFile &file, const qint64 size)
+{
+    if (file.isOpen() == false)
+        return false;
+
+    return file.resize(size);
+}
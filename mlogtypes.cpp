@@ -1,8 +1,46 @@
 #include "mlogtypes.h"
+#include "mlogutf8.h"
+
+#include <QStringView>
+
+namespace {
+
+/*!
+ * \internal
+ * Prints \a size bytes of UTF-8 encoded \a data to \a debug. Text is decoded
+ * into a thread-local buffer, which keeps its capacity, so no temporary
+ * QString is allocated for each message.
+ */
+void printUtf8(QDebug &debug, const char *data, const qsizetype size)
+{
+    static thread_local QString text;
+    if (text.capacity() == 0)
+        text.reserve(256);
+    text.resize(0);
+
+    mlog::appendUtf16(text, data, size);
+    debug << QStringView(text);
+}
+
+}
 
 QDebug operator<<(QDebug debug, const std::string &string)
 {
     QDebugStateSaver saver(debug);
-    debug << QString::fromStdString(string);
+    printUtf8(debug, string.data(), qsizetype(string.size()));
+    return debug;
+}
+
+QDebug operator<<(QDebug debug, std::string_view string)
+{
+    QDebugStateSaver saver(debug);
+    printUtf8(debug, string.data(), qsizetype(string.size()));
+    return debug;
+}
+
+QDebug operator<<(QDebug debug, const MLogUtf8 &text)
+{
+    QDebugStateSaver saver(debug);
+    printUtf8(debug, text.data, text.size);
     return debug;
 }
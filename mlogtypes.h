@@ -1,9 +1,69 @@
 #pragma once
 
+#include <QByteArray>
 #include <QDebug>
 
+#include <string>
+#include <string_view>
+
 /*!
  * Convenience overload for QDebug - it can now print \a string to \a debug
- * sink.
+ * sink. \a string is expected to be UTF-8 encoded.
  */
 QDebug operator<<(QDebug debug, const std::string &string);
+
+/*!
+ * Prints UTF-8 encoded \a string to \a debug sink.
+ */
+QDebug operator<<(QDebug debug, std::string_view string);
+
+/*!
+ * UTF-8 encoded text, which QDebug prints as text (QByteArray is printed as
+ * escaped bytes). Created by mlog::utf8().
+ */
+struct MLogUtf8
+{
+    const char *data = nullptr;
+    qsizetype size = 0;
+};
+
+/*!
+ * Prints UTF-8 encoded \a text to \a debug sink.
+ */
+QDebug operator<<(QDebug debug, const MLogUtf8 &text);
+
+namespace mlog {
+
+/*!
+ * Wraps UTF-8 encoded \a bytes, to print them with QDebug as text:
+ * \code
+ * qDebug() << mlog::utf8(reply->readAll());
+ * \endcode
+ *
+ * Bytes are not copied, \a bytes has to outlive the QDebug statement.
+ * In Qt 6, QUtf8StringView can be printed directly.
+ */
+inline MLogUtf8 utf8(const QByteArray &bytes)
+{
+    return MLogUtf8{ bytes.constData(), qsizetype(bytes.size()) };
+}
+
+//! Wraps UTF-8 encoded \a text, see utf8(const QByteArray &)
+inline MLogUtf8 utf8(std::string_view text)
+{
+    return MLogUtf8{ text.data(), qsizetype(text.size()) };
+}
+
+//! Wraps null-terminated, UTF-8 encoded \a text, see utf8(const QByteArray &)
+inline MLogUtf8 utf8(const char *text)
+{
+    return utf8(std::string_view(text ? text : ""));
+}
+
+//! Wraps UTF-8 encoded range from \a begin to \a end, see utf8(const QByteArray &)
+inline MLogUtf8 utf8(const char *begin, const char *end)
+{
+    return MLogUtf8{ begin, qsizetype(end - begin) };
+}
+
+}
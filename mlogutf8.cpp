@@ -0,0 +1,284 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogutf8.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/*!
+ * \internal
+ * Copies as many leading ASCII characters from \a src to \a dst as possible,
+ * several code units at a time. Stops at the first non-ASCII character (or
+ * shortly before \a end). Returns number of characters copied.
+ */
+qsizetype copyAscii(uchar *dst, const ushort *src, const ushort *end)
+{
+    const ushort *const start = src;
+#if defined(__SSE2__)
+    const __m128i nonAsciiMask = _mm_set1_epi16(short(0xff80));
+    const __m128i zero = _mm_setzero_si128();
+    while (end - src >= 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        const __m128i nonAscii = _mm_and_si128(chunk, nonAsciiMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xffff)
+            break;
+
+        // All 8 code units are < 0x80, so saturated packing is lossless
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                         _mm_packus_epi16(chunk, chunk));
+        src += 8;
+        dst += 8;
+    }
+#else
+    // Portable fallback: check 4 code units at once
+    while (end - src >= 4) {
+        quint64 chunk;
+        std::memcpy(&chunk, src, sizeof(chunk));
+        if (chunk & Q_UINT64_C(0xff80ff80ff80ff80))
+            break;
+
+        dst[0] = uchar(src[0]);
+        dst[1] = uchar(src[1]);
+        dst[2] = uchar(src[2]);
+        dst[3] = uchar(src[3]);
+        src += 4;
+        dst += 4;
+    }
+#endif
+    return src - start;
+}
+
+}
+
+/*!
+ * \internal
+ * Appends \a size UTF-16 code units starting at \a data to \a out, encoded as
+ * UTF-8. Output is the same as QString::toUtf8() (unpaired surrogates become
+ * U+FFFD), but no temporary QByteArray is created and runs of ASCII
+ * characters are converted several at a time.
+ *
+ * \a out is resized only twice: once to the worst case size and once to the
+ * final size, so its capacity is reused when it is a long-lived buffer.
+ */
+void mlog::appendUtf8(QByteArray &out, const QChar *data, const qsizetype size)
+{
+    if (size <= 0)
+        return;
+
+    const qsizetype oldSize = out.size();
+    // Worst case: 3 bytes per UTF-16 code unit (surrogate pairs take 4 bytes
+    // for 2 code units)
+    out.resize(oldSize + size * 3);
+
+    uchar *dst = reinterpret_cast<uchar *>(out.data()) + oldSize;
+    uchar *const begin = reinterpret_cast<uchar *>(out.data());
+    const ushort *src = reinterpret_cast<const ushort *>(data);
+    const ushort *const end = src + size;
+
+    while (src < end) {
+        const qsizetype copied = copyAscii(dst, src, end);
+        src += copied;
+        dst += copied;
+        if (src == end)
+            break;
+
+        const ushort unit = *src++;
+        if (unit < 0x80) {
+            *dst++ = uchar(unit);
+        } else if (unit < 0x800) {
+            *dst++ = uchar(0xc0 | (unit >> 6));
+            *dst++ = uchar(0x80 | (unit & 0x3f));
+        } else if (QChar::isHighSurrogate(unit) && src < end
+                   && QChar::isLowSurrogate(*src)) {
+            const uint codePoint = QChar::surrogateToUcs4(unit, *src++);
+            *dst++ = uchar(0xf0 | (codePoint >> 18));
+            *dst++ = uchar(0x80 | ((codePoint >> 12) & 0x3f));
+            *dst++ = uchar(0x80 | ((codePoint >> 6) & 0x3f));
+            *dst++ = uchar(0x80 | (codePoint & 0x3f));
+        } else {
+            const ushort character = QChar::isSurrogate(unit)
+                    ? ushort(QChar::ReplacementCharacter) : unit;
+            *dst++ = uchar(0xe0 | (character >> 12));
+            *dst++ = uchar(0x80 | ((character >> 6) & 0x3f));
+            *dst++ = uchar(0x80 | (character & 0x3f));
+        }
+    }
+
+    out.resize(dst - begin);
+}
+
+/*!
+ * \internal
+ * Returns number of bytes which \a size UTF-16 code units starting at \a data
+ * take when encoded by appendUtf8(), without encoding them.
+ */
+qsizetype mlog::utf8Size(const QChar *data, const qsizetype size)
+{
+    const ushort *src = reinterpret_cast<const ushort *>(data);
+    const ushort *const end = src + qMax(size, qsizetype(0));
+    qsizetype result = 0;
+    while (src < end) {
+        const ushort unit = *src++;
+        if (unit < 0x80) {
+            result += 1;
+        } else if (unit < 0x800) {
+            result += 2;
+        } else if (QChar::isHighSurrogate(unit) && src < end
+                   && QChar::isLowSurrogate(*src)) {
+            ++src;
+            result += 4;
+        } else {
+            result += 3;
+        }
+    }
+    return result;
+}
+
+/*!
+ * \internal
+ * Appends Latin-1 encoded \a text to \a out as UTF-8. If \a size is
+ * negative, \a text is null-terminated.
+ */
+void mlog::appendLatin1(QByteArray &out, const char *text, int size)
+{
+    if (text == nullptr)
+        return;
+
+    if (size < 0)
+        size = int(std::strlen(text));
+
+    for (int i = 0; i < size; ++i) {
+        const uchar c = uchar(text[i]);
+        if (c < 0x80) {
+            out.append(char(c));
+        } else {
+            out.append(char(0xc0 | (c >> 6)));
+            out.append(char(0x80 | (c & 0x3f)));
+        }
+    }
+}
+
+/*!
+ * \internal
+ * Appends decimal representation of \a value to \a out.
+ */
+void mlog::appendNumber(QByteArray &out, const qint64 value)
+{
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *pos = end;
+    quint64 magnitude = value < 0 ? 0 - quint64(value) : quint64(value);
+    do {
+        *--pos = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    if (value < 0)
+        *--pos = '-';
+    out.append(pos, int(end - pos));
+}
+
+/*!
+ * \internal
+ * Appends \a size bytes of UTF-8 encoded \a data to \a out. Output is the same
+ * as QString::fromUtf8() (invalid sequences become U+FFFD), but no temporary
+ * QString is created, so capacity of \a out is reused when it is a long-lived
+ * buffer.
+ */
+void mlog::appendUtf16(QString &out, const char *data, const qsizetype size)
+{
+    if (size <= 0)
+        return;
+
+    const qsizetype oldSize = out.size();
+    // Worst case: 1 UTF-16 code unit per byte (4 byte sequences become
+    // surrogate pairs)
+    out.resize(oldSize + size);
+
+    ushort *dst = reinterpret_cast<ushort *>(out.data()) + oldSize;
+    ushort *const begin = reinterpret_cast<ushort *>(out.data());
+    const uchar *src = reinterpret_cast<const uchar *>(data);
+    const uchar *const end = src + size;
+    static const uint minimum[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+
+    while (src < end) {
+        // ASCII runs, 8 bytes at a time
+        while (end - src >= 8) {
+            quint64 chunk;
+            std::memcpy(&chunk, src, sizeof(chunk));
+            if (chunk & Q_UINT64_C(0x8080808080808080))
+                break;
+            for (int i = 0; i < 8; ++i)
+                dst[i] = src[i];
+            src += 8;
+            dst += 8;
+        }
+        if (src == end)
+            break;
+
+        const uchar c = *src;
+        if (c < 0x80) {
+            *dst++ = c;
+            ++src;
+            continue;
+        }
+
+        int length = 0;
+        uint codePoint = 0;
+        if ((c & 0xe0) == 0xc0) {
+            length = 2;
+            codePoint = c & 0x1f;
+        } else if ((c & 0xf0) == 0xe0) {
+            length = 3;
+            codePoint = c & 0x0f;
+        } else if ((c & 0xf8) == 0xf0) {
+            length = 4;
+            codePoint = c & 0x07;
+        }
+
+        int used = 1;
+        while (used < length && src + used < end && (src[used] & 0xc0) == 0x80) {
+            codePoint = (codePoint << 6) | (src[used] & 0x3f);
+            ++used;
+        }
+        src += used;
+
+        if (used < length || length == 0 || codePoint < minimum[length]
+                || codePoint > 0x10ffff || (codePoint >= 0xd800 && codePoint < 0xe000)) {
+            *dst++ = ushort(QChar::ReplacementCharacter);
+        } else if (codePoint >= 0x10000) {
+            *dst++ = QChar::highSurrogate(codePoint);
+            *dst++ = QChar::lowSurrogate(codePoint);
+        } else {
+            *dst++ = ushort(codePoint);
+        }
+    }
+
+    out.resize(dst - begin);
+}
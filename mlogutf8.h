@@ -0,0 +1,51 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+/*!
+ * \internal
+ * Helpers used by MLog to encode log messages straight into its output
+ * buffers.
+ */
+namespace mlog {
+
+void appendUtf8(QByteArray &out, const QChar *data, const qsizetype size);
+void appendLatin1(QByteArray &out, const char *text, int size = -1);
+void appendNumber(QByteArray &out, const qint64 value);
+void appendUtf16(QString &out, const char *data, const qsizetype size);
+qsizetype utf8Size(const QChar *data, const qsizetype size);
+
+/*!
+ * \internal
+ * Appends \a string to \a out, encoded as UTF-8.
+ */
+inline void appendUtf8(QByteArray &out, const QString &string)
+{
+    appendUtf8(out, string.constData(), string.size());
+}
+
+}
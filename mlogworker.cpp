@@ -0,0 +1,218 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogworker.h"
+
+/*!
+ * \class MLogWorker
+ * \internal
+ * \brief Maintenance thread of MLog
+ *
+ * The thread is started when the first task is posted and sleeps on a wait
+ * condition while there is nothing to do.
+ */
+
+MLogWorker::MLogWorker()
+    : QThread()
+{
+    setObjectName(QStringLiteral("MLogWorker"));
+}
+
+/*!
+ * Runs all tasks which are still pending, then stops the thread.
+ */
+MLogWorker::~MLogWorker()
+{
+    stop();
+}
+
+/*!
+ * Schedules \a task to be run on the worker thread. Safe to call from any
+ * thread.
+ */
+void MLogWorker::post(std::function<void()> task)
+{
+    enqueue(std::move(task));
+}
+
+/*!
+ * Schedules \a task to be run on the worker thread in \a delay
+ * milliseconds. Once due, it is queued behind tasks posted before. Tasks
+ * still waiting when the worker is stopped are run right away.
+ */
+void MLogWorker::postDelayed(std::function<void()> task, const int delay)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping)
+        return;
+
+    m_delayedTasks.append({ QDeadlineTimer(qMax(delay, 0)), std::move(task) });
+    if (isRunning() == false)
+        start();
+    m_taskCondition.wakeOne();
+}
+
+/*!
+ * Runs \a task on the worker thread and blocks until it is done. Tasks
+ * posted earlier are run first, tasks posted later (for example long tasks
+ * which gave way to this one) are not waited for.
+ *
+ * When called from the worker thread or after stop(), \a task is run
+ * directly.
+ */
+void MLogWorker::execute(std::function<void()> task)
+{
+    if (currentThread() == this) {
+        task();
+        return;
+    }
+
+    const quint64 ticket = enqueue(std::move(task));
+    if (ticket == 0) {
+        // Not queued, task was left untouched
+        task();
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_finishedCount < ticket)
+        m_finishedCondition.wait(&m_mutex);
+}
+
+/*!
+ * Returns true if there are tasks waiting to be run. Long running tasks use
+ * it to give way to others.
+ */
+bool MLogWorker::hasPendingTasks()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_tasks.isEmpty() == false)
+        return true;
+
+    for (const DelayedTask &delayed : qAsConst(m_delayedTasks)) {
+        if (delayed.deadline.hasExpired())
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Runs \a task with the worker thread lowered to \a priority, then puts the
+ * thread back to normal priority. Must be called from a task. Long, low
+ * priority tasks (like compression) use it, so that tasks which run after
+ * them - file flushes, console output - are not slowed down.
+ */
+void MLogWorker::runWithPriority(const QThread::Priority priority,
+                                 const std::function<void()> &task)
+{
+    Q_ASSERT(currentThread() == this);
+    if (priority == QThread::InheritPriority) {
+        task();
+        return;
+    }
+
+    setPriority(priority);
+    task();
+    setPriority(QThread::NormalPriority);
+}
+
+/*!
+ * Runs all pending tasks and stops the thread. Tasks posted afterwards are
+ * ignored.
+ */
+void MLogWorker::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_taskCondition.wakeOne();
+    }
+    wait();
+}
+
+void MLogWorker::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        const int timeout = takeDueTasks();
+        if (m_tasks.isEmpty()) {
+            if (m_stopping)
+                return;
+            if (timeout < 0)
+                m_taskCondition.wait(&m_mutex);
+            else
+                m_taskCondition.wait(&m_mutex, ulong(timeout));
+            continue;
+        }
+
+        const std::function<void()> task = m_tasks.dequeue();
+        locker.unlock();
+        task();
+        locker.relock();
+        ++m_finishedCount;
+        m_finishedCondition.wakeAll();
+    }
+}
+
+/*!
+ * Moves delayed tasks which are due (all of them when stopping) to the
+ * queue. Returns number of milliseconds until the next one is due, or -1 if
+ * there are none left. Must be called with m_mutex locked.
+ */
+int MLogWorker::takeDueTasks()
+{
+    qint64 timeout = -1;
+    for (int i = 0; i < m_delayedTasks.size();) {
+        DelayedTask &delayed = m_delayedTasks[i];
+        const qint64 remaining = delayed.deadline.remainingTime();
+        if (m_stopping || remaining == 0) {
+            m_tasks.enqueue(std::move(delayed.task));
+            ++m_postedCount;
+            m_delayedTasks.remove(i);
+            continue;
+        }
+
+        if (timeout < 0 || remaining < timeout)
+            timeout = remaining;
+        ++i;
+    }
+    return int(timeout);
+}
+
+/*!
+ * Adds \a task to the queue, starting the thread if needed. Returns the
+ * task's ticket: the task is done once that many tasks have finished.
+ * Returns 0 (and drops \a task) after stop().
+ */
+quint64 MLogWorker::enqueue(std::function<void()> &&task)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping)
+        return 0;
+
+    m_tasks.enqueue(std::move(task));
+    if (isRunning() == false)
+        start();
+    m_taskCondition.wakeOne();
+    return ++m_postedCount;
+}
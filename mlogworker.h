@@ -0,0 +1,79 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QDeadlineTimer>
+
+#include <functional>
+
+/*!
+ * \internal
+ * Background thread which runs MLog's maintenance tasks (log rotation,
+ * cleanup and compression), so that they never hold up threads which log
+ * messages.
+ *
+ * Tasks are run one by one, in the order in which they were posted. Long
+ * tasks (like compression) should check hasPendingTasks() and step aside
+ * for more urgent ones.
+ */
+class MLogWorker : public QThread
+{
+public:
+    MLogWorker();
+    ~MLogWorker() override;
+
+    void post(std::function<void()> task);
+    void postDelayed(std::function<void()> task, const int delay);
+    void execute(std::function<void()> task);
+    bool hasPendingTasks();
+    void runWithPriority(const QThread::Priority priority,
+                         const std::function<void()> &task);
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    struct DelayedTask {
+        QDeadlineTimer deadline;
+        std::function<void()> task;
+    };
+
+    quint64 enqueue(std::function<void()> &&task);
+    int takeDueTasks();
+
+    QMutex m_mutex;
+    QWaitCondition m_taskCondition;
+    QWaitCondition m_finishedCondition;
+    QQueue<std::function<void()>> m_tasks;
+    QVector<DelayedTask> m_delayedTasks;
+    quint64 m_postedCount = 0;
+    quint64 m_finishedCount = 0;
+    bool m_stopping = false;
+};
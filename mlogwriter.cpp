@@ -0,0 +1,175 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "mlogwriter.h"
+
+/*!
+ * \class MLogWriter
+ * \internal
+ * \brief Asynchronous writer thread of MLog
+ *
+ * Messages are pushed into a bounded MLogQueue by any number of threads and
+ * written out (formatted, encoded, saved to file and printed to console) by
+ * this single thread. When the queue is empty the thread sleeps on a wait
+ * condition, producers only touch the mutex when the writer is actually
+ * asleep.
+ */
+
+/*!
+ * Creates writer for \a log with a queue able to hold \a queueSize messages.
+ * \a policy decides what happens when the queue is full.
+ */
+MLogWriter::MLogWriter(MLog *log, const int queueSize,
+                       const MLog::OverflowPolicy policy)
+    : QThread(), m_log(log), m_queue(std::size_t(qMax(queueSize, 2))),
+      m_policy(policy)
+{
+    setObjectName(QStringLiteral("MLogWriter"));
+}
+
+/*!
+ * Puts \a message into the queue and wakes the writer if needed. Safe to call
+ * from any thread.
+ *
+ * If the queue is full, this call either waits for the writer to make some
+ * space (MLog::OverflowPolicy::Block) or drops the message and returns false
+ * (MLog::OverflowPolicy::Drop).
+ */
+bool MLogWriter::enqueue(MLogMessage &&message)
+{
+    while (m_queue.push(std::move(message)) == false) {
+        if (m_policy == MLog::OverflowPolicy::Drop || currentThread() == this) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        wake();
+        yieldCurrentThread();
+    }
+
+    wake();
+    return true;
+}
+
+/*!
+ * Blocks until all messages enqueued before this call have been written.
+ *
+ * Does nothing when called from the writer thread itself.
+ */
+void MLogWriter::drain()
+{
+    if (currentThread() == this || isRunning() == false)
+        return;
+
+    const std::size_t target = m_queue.enqueuedCount();
+    QMutexLocker locker(&m_mutex);
+    while (m_processed.load(std::memory_order_acquire) < target && isRunning()) {
+        m_wakeCondition.wakeOne();
+        m_drainedCondition.wait(&m_mutex, 10);
+    }
+}
+
+/*!
+ * Writes out all pending messages and stops the thread.
+ */
+void MLogWriter::stop()
+{
+    m_stopping.store(true);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_wakeCondition.wakeOne();
+    }
+    wait();
+}
+
+/*!
+ * Returns number of messages dropped because the queue was full.
+ */
+quint64 MLogWriter::droppedCount() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Returns number of messages waiting in the queue.
+ */
+quint64 MLogWriter::queueDepth() const
+{
+    const std::size_t enqueued = m_queue.enqueuedCount();
+    const std::size_t dequeued = m_queue.dequeuedCount();
+    return enqueued > dequeued ? quint64(enqueued - dequeued) : 0;
+}
+
+void MLogWriter::run()
+{
+    // Messages handled between two writes to disk, unless queue runs empty
+    const int maxBatchSize = 4096;
+
+    MLogMessage message;
+    for (;;) {
+        std::size_t processed = m_processed.load(std::memory_order_relaxed);
+        int batchSize = 0;
+        while (batchSize < maxBatchSize && m_queue.pop(message)) {
+            m_log->output(message);
+            ++processed;
+            ++batchSize;
+        }
+
+        // Good moment to hit the disk. Messages count as processed only once
+        // they are written out, drain() relies on that
+        m_log->writePendingOutput();
+        m_processed.store(processed, std::memory_order_release);
+
+        QMutexLocker locker(&m_mutex);
+        m_drainedCondition.wakeAll();
+
+        if (batchSize == maxBatchSize)
+            continue;
+
+        if (m_stopping.load()) {
+            if (m_queue.isEmpty())
+                break;
+            continue;
+        }
+
+        // Pairs with the fence in wake(): either the producer sees that we are
+        // going to sleep, or we see its message
+        m_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_queue.isEmpty())
+            m_wakeCondition.wait(&m_mutex, 100);
+        m_sleeping.store(false);
+    }
+}
+
+/*!
+ * Wakes the writer thread if it is sleeping.
+ */
+void MLogWriter::wake()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed)) {
+        QMutexLocker locker(&m_mutex);
+        m_wakeCondition.wakeOne();
+    }
+}
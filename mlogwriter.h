@@ -0,0 +1,71 @@
+/*******************************************************************************
+Copyright (C) 2026 Milo Solutions
+Contact: https://www.milosolutions.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+
+#include "mlog.h"
+#include "mlogmessage.h"
+#include "mlogqueue.h"
+
+/*!
+ * \internal
+ * Background thread used by MLog in asynchronous mode. Producers only push
+ * messages into a lock-free queue, formatting and all output happen here.
+ *
+ * \sa MLog::enableAsyncLogging
+ */
+class MLogWriter : public QThread
+{
+public:
+    MLogWriter(MLog *log, const int queueSize, const MLog::OverflowPolicy policy);
+
+    bool enqueue(MLogMessage &&message);
+    void drain();
+    void stop();
+
+    quint64 droppedCount() const;
+    quint64 queueDepth() const;
+
+protected:
+    void run() override;
+
+private:
+    void wake();
+
+    MLog *m_log = nullptr;
+    MLogQueue<MLogMessage> m_queue;
+    const MLog::OverflowPolicy m_policy;
+    QMutex m_mutex;
+    QWaitCondition m_wakeCondition;
+    QWaitCondition m_drainedCondition;
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_stopping{false};
+    std::atomic<std::size_t> m_processed{0};
+    std::atomic<quint64> m_dropped{0};
+};
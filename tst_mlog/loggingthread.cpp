@@ -23,13 +23,15 @@ SOFTWARE.
 
 #include "loggingthread.h"
 
-LoggingThread::LoggingThread()
-    : QThread()
+LoggingThread::LoggingThread(const int iterations)
+    : QThread(), m_iterations(iterations)
 {
 }
 
 void LoggingThread::run()
 {
-    qDebug() << "Thread_start";
-    qDebug() << "Thread_finish";
+    for (int i = 0; i < m_iterations; ++i) {
+        qDebug() << "Thread_start";
+        qDebug() << "Thread_finish";
+    }
 }
@@ -30,10 +30,12 @@ SOFTWARE.
 class LoggingThread : public QThread
 {
 public:
-    LoggingThread();
+    explicit LoggingThread(const int iterations = 1);
 
 private:
     void run();
+
+    int m_iterations = 1;
 };
 
 #endif // LOGGINGTHREAD_H
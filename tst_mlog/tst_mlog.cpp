@@ -23,11 +23,63 @@ SOFTWARE.
 
 #include <QtTest>
 #include <QCoreApplication>
+#include <QTextStream>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPoint>
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
 
 #include "../mlog.h"
+#include "../mlogutf8.h"
+#include "../mlogformatter.h"
+#include "../mlogclock.h"
+#include "../mlogbinary.h"
+#include "../mloggzip.h"
+#include "../mlogsink.h"
+#include "../mlogstatistics.h"
+#include "../mlogformat.h"
 
 #include "loggingthread.h"
 
+Q_LOGGING_CATEGORY(testLogger, "test.logger")
+
+/*!
+ * Adds a memory sink formatting with \a pattern and disables console output
+ * while the object lives. The destructor removes the sink and resets the
+ * filters tests turn on, also when a failed check returns from the test early.
+ */
+class MemorySinkScope
+{
+public:
+    explicit MemorySinkScope(const QString &pattern)
+        : m_sink(new MLogMemorySink)
+    {
+        m_sink->setMessagePattern(pattern);
+        logger()->addSink(m_sink);
+        logger()->disableLogToConsole();
+    }
+
+    ~MemorySinkScope()
+    {
+        logger()->disableRateLimit();
+        logger()->setCollapseRepeatedMessages(false);
+        logger()->clearSampling();
+        logger()->clearCategoryLogLevels();
+        logger()->removeSink(m_sink);
+        logger()->enableLogToConsole();
+    }
+
+    MLogMemorySink *operator->() const { return m_sink; }
+
+private:
+    Q_DISABLE_COPY(MemorySinkScope)
+    MLogMemorySink *m_sink;
+};
+
 class TestMLog : public QObject
 {
   Q_OBJECT
@@ -40,7 +92,41 @@ private slots:
     void testLogToConsole();
     void testInThread();
     void testInMultipleThreads();
+    void testReconfigureUnderLoad();
     void testCustomTypes();
+    void testUtf8Types();
+    void testLevelMacros();
+    void testCategoryLogLevels();
+    void testAsyncLogging();
+    void testUtf8Encoding_data();
+    void testUtf8Encoding();
+    void testMessagePattern_data();
+    void testMessagePattern();
+    void testCachedTime_data();
+    void testCachedTime();
+    void testBinaryFormat();
+    void testJsonFormat();
+    void testSinks();
+    void testConsoleFlushPolicy();
+    void testFileDurability();
+    void testFlightRecorder();
+    void testRateLimit();
+    void testCollapseRepeated();
+    void testSampling();
+    void testStatistics();
+    void testCallSiteProfiling();
+    void testFormattedLogging();
+    void testThreadBuffering();
+    void testRuntimeRotation();
+    void testRotationManifest();
+    void testGzip();
+    void testLogCompression();
+    void benchmarkFileWrite_data();
+    void benchmarkFileWrite();
+    void benchmarkTimestamp_data();
+    void benchmarkTimestamp();
+    void benchmarkEnableLogToFile_data();
+    void benchmarkEnableLogToFile();
 
 private:
     void clean();
@@ -180,6 +266,64 @@ void TestMLog::testInMultipleThreads()
     clean();
 }
 
+void TestMLog::testReconfigureUnderLoad()
+{
+    logger()->enableLogToFile("Reconfigured log",
+                              QCoreApplication::applicationDirPath());
+    logger()->disableLogToConsole();
+
+    const int numberOfThreads = 32;
+    QVector<LoggingThread*> threadVec;
+    for (int i = 0 ; i < numberOfThreads; i++)
+        threadVec.push_back(new LoggingThread(500));
+
+    Q_FOREACH(LoggingThread *thread, threadVec)
+        thread->start();
+
+    // Change everything which logging threads read, while they log
+    int round = 0;
+    const auto isRunning = [&threadVec]() {
+        return std::any_of(threadVec.cbegin(), threadVec.cend(),
+                           [](const LoggingThread *thread) { return thread->isRunning(); });
+    };
+    while (isRunning() || round < 10) {
+        const bool odd = (round++ % 2) != 0;
+        logger()->setClockSource(odd ? MLog::ClockSource::Coarse : MLog::ClockSource::System,
+                                 odd ? MLog::TimestampPrecision::Seconds
+                                     : MLog::TimestampPrecision::Milliseconds);
+        logger()->setLogLevel(odd ? MLog::InfoLog : MLog::DebugLog);
+        if (odd)
+            logger()->enableAsyncLogging();
+        else
+            logger()->disableAsyncLogging();
+        logger()->disableLogToFile();
+        logger()->enableLogToFile("Reconfigured log",
+                                  QCoreApplication::applicationDirPath());
+    }
+
+    Q_FOREACH(LoggingThread *thread, threadVec)
+        thread->wait();
+    qDeleteAll(threadVec);
+
+    logger()->disableAsyncLogging();
+    logger()->setLogLevel(MLog::DebugLog);
+    logger()->setClockSource(MLog::ClockSource::System);
+    QVERIFY(!logger()->isAsyncLogging());
+    QCOMPARE(logger()->clockSource(), MLog::ClockSource::System);
+
+    // Messages are never torn, whatever configuration they were written with
+    QFile logFile(logger()->currentLogPath());
+    QVERIFY(logFile.open(QFile::ReadOnly | QFile::Text));
+    while (!logFile.atEnd()) {
+        const QByteArray line = logFile.readLine();
+        QVERIFY(line.endsWith("Thread_start\n") || line.endsWith("Thread_finish\n"));
+    }
+    logFile.close();
+
+    logger()->enableLogToConsole();
+    clean();
+}
+
 void TestMLog::testCustomTypes()
 {
     logger()->enableLogToFile(QCoreApplication::applicationName(),
@@ -195,6 +339,1107 @@ void TestMLog::testCustomTypes()
     clean();
 }
 
+void TestMLog::testUtf8Types()
+{
+    MemorySinkScope sink(QStringLiteral("%{message}"));
+
+    const QByteArray bytes("\xc5\xbc\xc3\xb3\xc5\x82w");
+    const std::string_view view("view");
+    const char range[] = "range|skipped";
+    qInfo() << std::string("\xc4\x85");
+    qInfo().noquote() << view << mlog::utf8(bytes) << mlog::utf8(range, range + 5);
+    QCOMPARE(sink->lines(), QStringList({
+        QString::fromUtf8("\"\xc4\x85\""),
+        QString::fromUtf8("view \xc5\xbc\xc3\xb3\xc5\x82w range")
+    }));
+}
+
+void TestMLog::testLevelMacros()
+{
+    int evaluated = 0;
+    const auto argument = [&evaluated]() { return ++evaluated; };
+
+    // Disabled messages do not even evaluate their arguments
+    logger()->setLogLevel(MLog::WarningLog);
+    QVERIFY(!MLog::isLevelEnabled(MLog::InfoLog));
+    mDebug(MColorLog::Red) << argument();
+    mInfo(MColorLog::Red) << argument();
+    mCDebug(MColorLog::Green, testLogger) << argument();
+    mCInfo(MColorLog::Green, testLogger).nospace() << argument();
+    QCOMPARE(evaluated, 0);
+
+    mWarning(MColorLog::Blue) << argument();
+    mCWarning(MColorLog::Blue, testLogger) << argument();
+    QCOMPARE(evaluated, 2);
+
+    // Category filter is respected too
+    logger()->setLogLevel(MLog::DebugLog);
+    QLoggingCategory::setFilterRules(QStringLiteral("test.logger.warning=false"));
+    mCWarning(MColorLog::Cyan, testLogger) << argument();
+    QCOMPARE(evaluated, 2);
+    QLoggingCategory::setFilterRules(QString());
+}
+
+void TestMLog::testCategoryLogLevels()
+{
+    logger()->setLogLevel(MLog::WarningLog);
+    QVERIFY(logger()->setCategoryLogLevels(QStringLiteral("test.*=debug; test.logger=info")));
+    QCOMPARE(logger()->categoryLogLevel("test.net"), MLog::DebugLog);
+    QCOMPARE(logger()->categoryLogLevel("test.logger"), MLog::InfoLog);
+    QCOMPARE(logger()->categoryLogLevel("other"), MLog::WarningLog);
+
+    // Existing categories are updated
+    QVERIFY(!testLogger().isDebugEnabled());
+    QVERIFY(testLogger().isInfoEnabled());
+    QVERIFY(!QLoggingCategory::defaultCategory()->isInfoEnabled());
+
+    // And so are new ones
+    QLoggingCategory netLogger("test.net");
+    QVERIFY(netLogger.isDebugEnabled());
+    QLoggingCategory otherLogger("other.net");
+    QVERIFY(!otherLogger.isInfoEnabled());
+    QVERIFY(otherLogger.isWarningEnabled());
+
+    // Qt rules still apply, and last matching rule wins
+    QLoggingCategory::setFilterRules(QStringLiteral("test.net.debug=false"));
+    QVERIFY(!netLogger.isDebugEnabled());
+    QVERIFY(netLogger.isInfoEnabled());
+    QLoggingCategory::setFilterRules(QString());
+    logger()->setCategoryLogLevel(QStringLiteral("*.net"), MLog::CriticalLog);
+    QVERIFY(!netLogger.isWarningEnabled());
+    QVERIFY(netLogger.isCriticalEnabled());
+
+    QVERIFY(!logger()->setCategoryLogLevels(QStringLiteral("test.*=verbose, =debug, test.logger=debug")));
+    QCOMPARE(logger()->categoryLogLevel("test.logger"), MLog::DebugLog);
+    QCOMPARE(logger()->categoryLogLevel("test.net"), MLog::WarningLog);
+
+    logger()->clearCategoryLogLevels();
+    logger()->setLogLevel(MLog::DebugLog);
+    QVERIFY(testLogger().isDebugEnabled());
+    QVERIFY(netLogger.isDebugEnabled());
+}
+
+void TestMLog::testAsyncLogging()
+{
+    logger()->enableLogToFile("Async log",
+                              QCoreApplication::applicationDirPath());
+    QFile logFile(logger()->currentLogPath());
+
+    LoggingThread thread;
+    thread.start();
+    thread.wait();
+    const qint64 singleThreadSize = logFile.size();
+    QVERIFY(singleThreadSize > 0);
+
+    logger()->enableAsyncLogging();
+    QVERIFY(logger()->isAsyncLogging());
+
+    const int numberOfThreads = 20;
+    QVector<LoggingThread*> threadVec;
+    for (int i = 0 ; i < numberOfThreads; i++)
+        threadVec.push_back(new LoggingThread());
+
+    for (LoggingThread *loggingThread : qAsConst(threadVec))
+        loggingThread->start();
+
+    for (LoggingThread *loggingThread : qAsConst(threadVec))
+        loggingThread->wait();
+
+    qDeleteAll(threadVec);
+    threadVec.clear();
+
+    // Everything logged so far must be in the file after flush()
+    logger()->flush();
+    QCOMPARE(logFile.size(), singleThreadSize * (numberOfThreads + 1));
+
+    // disableLogToFile() drains the queue before closing the file
+    qInfo() << "Last async message";
+    logger()->disableLogToFile();
+    QVERIFY(logFile.size() > singleThreadSize * (numberOfThreads + 1));
+
+    // QML and other runtime call sites free their strings after logging
+    {
+        MemorySinkScope sink(QStringLiteral("%{file}|%{function}|%{message}"));
+        QByteArray file("runtime.qml");
+        QByteArray function("onClicked");
+        QMessageLogger(file.constData(), 1, function.constData(), "test.logger").info()
+                << "Queued";
+        file.fill('x');
+        function.fill('x');
+        logger()->flush();
+        QCOMPARE(sink->lines(),
+                 QStringList({ QStringLiteral("runtime.qml|onClicked|Queued") }));
+    }
+
+    logger()->disableAsyncLogging();
+    QVERIFY(!logger()->isAsyncLogging());
+    QCOMPARE(logger()->droppedMessageCount(), quint64(0));
+    clean();
+}
+
+void TestMLog::testUtf8Encoding_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::newRow("ascii") << QStringLiteral("Plain ASCII text, long enough for the fast path");
+    QTest::newRow("latin") << QString::fromUtf8("Za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87 g\xc4\x99\xc5\x9bl\xc4\x85 ja\xc5\xba\xc5\x84");
+    QTest::newRow("cjk") << QString::fromUtf8("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e and some ASCII after it");
+    QTest::newRow("surrogate pair") << QString::fromUtf8("emoji \xf0\x9f\x98\x80 in the middle");
+    QTest::newRow("lone surrogate") << QString(QStringLiteral("broken ") + QChar(0xd800)
+                                               + QStringLiteral("x"));
+    QTest::newRow("empty") << QString();
+}
+
+void TestMLog::testUtf8Encoding()
+{
+    QFETCH(QString, text);
+    QByteArray encoded("prefix|");
+    mlog::appendUtf8(encoded, text);
+    const QByteArray expected = QByteArray("prefix|") + text.toUtf8();
+    QCOMPARE(encoded, expected);
+    QCOMPARE(mlog::utf8Size(text.constData(), text.size()),
+             qsizetype(text.toUtf8().size()));
+
+    const QByteArray utf8 = text.toUtf8();
+    QString decoded(QStringLiteral("prefix|"));
+    mlog::appendUtf16(decoded, utf8.constData(), utf8.size());
+    QCOMPARE(decoded, QString(QStringLiteral("prefix|") + QString::fromUtf8(utf8)));
+}
+
+void TestMLog::testMessagePattern_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<int>("type");
+    QTest::addColumn<QByteArray>("function");
+    QTest::addColumn<QByteArray>("category");
+
+    const QString defaultPattern = QStringLiteral(
+        "%{type}%{if-category}|%{category}%{endif}|%{function}: %{message}");
+    QTest::newRow("default, no category") << defaultPattern << int(QtInfoMsg)
+        << QByteArray("void TestMLog::testMessagePattern()") << QByteArray("default");
+    QTest::newRow("default, category") << defaultPattern << int(QtWarningMsg)
+        << QByteArray("void TestMLog::testMessagePattern()") << QByteArray("core.test");
+    QTest::newRow("template function") << defaultPattern << int(QtDebugMsg)
+        << QByteArray("QList<T> ns::Container<T>::items(int) const [with T = int]")
+        << QByteArray("core.test");
+    QTest::newRow("operator") << defaultPattern << int(QtCriticalMsg)
+        << QByteArray("bool operator<(const Foo&, const Foo&)") << QByteArray("core.test");
+    QTest::newRow("function pointer") << defaultPattern << int(QtDebugMsg)
+        << QByteArray("void (* getHandler(int))(int)") << QByteArray("core.test");
+    QTest::newRow("file and line") << QStringLiteral("%{file}:%{line} %{message}")
+        << int(QtDebugMsg) << QByteArray("int main()") << QByteArray("core.test");
+    QTest::newRow("conditions") << QStringLiteral(
+        "%{if-debug}D%{endif}%{if-info}I%{endif}%{if-warning}W%{endif}|%{message}")
+        << int(QtWarningMsg) << QByteArray("int main()") << QByteArray("core.test");
+    QTest::newRow("time with format") << QStringLiteral("%{time yyyy-MM-dd}|%{message}")
+        << int(QtInfoMsg) << QByteArray("int main()") << QByteArray("core.test");
+}
+
+void TestMLog::testMessagePattern()
+{
+    QFETCH(QString, pattern);
+    QFETCH(int, type);
+    QFETCH(QByteArray, function);
+    QFETCH(QByteArray, category);
+
+    const QString oldPattern = logger()->messagePattern();
+    qSetMessagePattern(pattern);
+
+    MLogMessage message;
+    message.type = QtMsgType(type);
+    message.file = "tst_mlog.cpp";
+    message.line = 42;
+    message.function = function.constData();
+    message.category = category.constData();
+    message.timestamp = QDateTime::currentMSecsSinceEpoch();
+    message.message = QString::fromUtf8("Zażółć gęślą jaźń");
+
+    const QMessageLogContext context(message.file, message.line,
+                                     message.function, message.category);
+    const QByteArray expected = qFormatLogMessage(message.type, context,
+                                                  message.message).toUtf8();
+
+    const MLogFormatter formatter(pattern);
+    QByteArray formatted;
+    formatter.format(formatted, message);
+    QCOMPARE(formatted, expected);
+
+    logger()->setMessagePattern(oldPattern);
+}
+
+void TestMLog::testCachedTime_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::newRow("ISO date") << QString();
+    QTest::newRow("milliseconds") << QStringLiteral("yyyy-MM-dd HH:mm:ss.zzz");
+    QTest::newRow("quoted") << QStringLiteral("HH:mm:ss.zzz 'zzz'");
+    QTest::newRow("am/pm") << QStringLiteral("h:mm:ss.zzz ap");
+    QTest::newRow("short milliseconds") << QStringLiteral("ss.z");
+}
+
+void TestMLog::testCachedTime()
+{
+    QFETCH(QString, format);
+    const MLogFormatter formatter(format.isEmpty() ? QStringLiteral("%{time}")
+                                                   : QString("%{time " + format + "}"));
+    QVERIFY(formatter.isCompiled());
+
+    const qint64 base = QDateTime::currentMSecsSinceEpoch() / 1000 * 1000;
+    const qint64 offsets[] = { 0, 1, 999, 1000, 1500, 1500, 61001 };
+    for (const qint64 offset : offsets) {
+        MLogMessage message;
+        message.timestamp = base + offset;
+
+        const QDateTime time(QDateTime::fromMSecsSinceEpoch(message.timestamp));
+        const QByteArray expected = format.isEmpty()
+                ? time.toString(Qt::ISODate).toUtf8()
+                : time.toString(format).toUtf8();
+
+        QByteArray formatted;
+        formatter.format(formatted, message);
+        QCOMPARE(formatted, expected);
+    }
+}
+
+void TestMLog::testBinaryFormat()
+{
+    // No %{time}, so that both runs produce the same text
+    const QString defaultPattern = logger()->messagePattern();
+    logger()->setMessagePattern(QStringLiteral(
+        "%{type}|%{category}|%{function}:%{line}|%{pid}: %{message}"));
+
+    QByteArray logs[2];
+    const MLog::FileFormat formats[2] = { MLog::FileFormat::Text,
+                                          MLog::FileFormat::Binary };
+    for (int run = 0; run < 2; ++run) {
+        logger()->setFileFormat(formats[run]);
+        logger()->enableLogToFile("Binary log",
+                                  QCoreApplication::applicationDirPath());
+        for (int i = 0; i < 3; ++i) {
+            qInfo() << "Message" << i << QString::fromUtf8("\xc5\xbc\xc3\xb3\xc5\x82w");
+            qCWarning(testLogger) << "Warning" << i;
+            mCRecord(QtInfoMsg, testLogger).field("index", i).field("name", "a b") << "Record";
+        }
+        logger()->writeRaw(QtInfoMsg, QStringLiteral("Raw text\n"));
+        logger()->disableLogToFile();
+
+        QFile logFile(logger()->currentLogPath());
+        QVERIFY(logFile.open(QFile::ReadOnly));
+        logs[run] = logFile.readAll();
+        logFile.close();
+        clean();
+    }
+    logger()->setFileFormat(MLog::FileFormat::Text);
+    logger()->setMessagePattern(defaultPattern);
+
+    QBuffer binary(&logs[1]);
+    QVERIFY(binary.open(QBuffer::ReadOnly));
+    MLogBinaryReader reader(&binary);
+    QVERIFY(reader.readHeader());
+    QCOMPARE(reader.appName(), QStringLiteral("Binary log"));
+
+    MLogFormatter formatter(reader.pattern());
+    formatter.setApplication(reader.appName(), reader.pid());
+    QByteArray decoded;
+    MLogMessage message;
+    MLogBinaryReader::Result result;
+    while ((result = reader.next(message)) != MLogBinaryReader::Result::End) {
+        QVERIFY(result != MLogBinaryReader::Result::Error);
+        if (result == MLogBinaryReader::Result::Raw) {
+            decoded.append(message.message.toUtf8());
+        } else {
+            formatter.format(decoded, message);
+            decoded.append('\n');
+        }
+    }
+
+    QCOMPARE(decoded, logs[0]);
+    QVERIFY(logs[0].contains("Record index=0 name=\"a b\"\n"));
+}
+
+void TestMLog::testJsonFormat()
+{
+    logger()->setFileFormat(MLog::FileFormat::Json);
+    logger()->enableLogToFile("Json log", QCoreApplication::applicationDirPath());
+    const QString text = QString::fromUtf8("Quoted \"\xc5\xbc\xc3\xb3\xc5\x82w\"\tand\\\n");
+    qCInfo(testLogger).noquote() << text;
+    mCRecord(QtWarningMsg, testLogger).field("count", 42).field("ratio", 0.25)
+            .field("ok", true).field("name", text) << "Structured" << 7;
+    mRecord(QtDebugMsg).field("huge", Q_INT64_C(-9007199254740993)) << "Default";
+    logger()->writeRaw(QtInfoMsg, QStringLiteral("Raw\n"));
+    // UTF-8 message, escaped without converting to QString
+    mlog::warning(testLogger, "{}", text.toStdString());
+    logger()->disableLogToFile();
+    logger()->setFileFormat(MLog::FileFormat::Text);
+
+    QFile logFile(logger()->currentLogPath());
+    QVERIFY(logFile.open(QFile::ReadOnly));
+    QVector<QJsonObject> records;
+    while (!logFile.atEnd()) {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(logFile.readLine(), &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        records.append(document.object());
+    }
+    logFile.close();
+    clean();
+
+    QCOMPARE(records.size(), 5);
+    QCOMPARE(records.at(0).value("level").toString(), QStringLiteral("info"));
+    QCOMPARE(records.at(0).value("category").toString(), QStringLiteral("test.logger"));
+    QCOMPARE(records.at(0).value("message").toString(), text);
+    QVERIFY(records.at(0).value("time").toDouble() > 0);
+    QVERIFY(records.at(0).contains("thread"));
+    QVERIFY(!records.at(0).contains("fields"));
+
+    const QJsonObject fields = records.at(1).value("fields").toObject();
+    QCOMPARE(records.at(1).value("level").toString(), QStringLiteral("warning"));
+    QCOMPARE(records.at(1).value("message").toString(), QStringLiteral("Structured 7"));
+    QCOMPARE(fields.value("count").toInt(), 42);
+    QCOMPARE(fields.value("ratio").toDouble(), 0.25);
+    QCOMPARE(fields.value("ok").toBool(), true);
+    QCOMPARE(fields.value("name").toString(), text);
+
+    QCOMPARE(records.at(2).value("category").toString(), QStringLiteral("default"));
+    QCOMPARE(records.at(3).value("message").toString(), QStringLiteral("Raw\n"));
+    QVERIFY(!records.at(3).contains("thread"));
+    QCOMPARE(records.at(4).value("message").toString(), text);
+}
+
+void TestMLog::testSinks()
+{
+    const QString shortPattern = QStringLiteral("%{type}: %{message}");
+    MLogMemorySink *all = new MLogMemorySink(3);
+    MLogMemorySink *warnings = new MLogMemorySink;
+    warnings->setLogLevel(MLog::WarningLog);
+    MLogMemorySink *shortLines = new MLogMemorySink;
+    shortLines->setMessagePattern(shortPattern);
+    MLogMemorySink *shortLines2 = new MLogMemorySink;
+    shortLines2->setMessagePattern(shortPattern);
+    const QString filePath = QCoreApplication::applicationDirPath()
+            + QStringLiteral("/Sink log.log");
+    QFile::remove(filePath);
+    MLogFileSink *file = new MLogFileSink(filePath);
+    file->setMessagePattern(QStringLiteral("%{category}|%{message}"));
+    QVERIFY(file->isOpen());
+    QCOMPARE(shortLines->messagePattern(), shortPattern);
+    QVERIFY(all->messagePattern().isEmpty());
+
+    for (MLogSink *sink : { static_cast<MLogSink *>(all), static_cast<MLogSink *>(warnings),
+                            static_cast<MLogSink *>(shortLines),
+                            static_cast<MLogSink *>(shortLines2),
+                            static_cast<MLogSink *>(file) }) {
+        logger()->addSink(sink);
+    }
+    logger()->addSink(all);
+    QCOMPARE(logger()->sinks().size(), 5);
+
+    logger()->disableLogToConsole();
+    qDebug() << "First";
+    qCWarning(testLogger) << "Second";
+    qInfo() << "Third";
+    qCritical() << "Fourth";
+    logger()->writeRaw(QtWarningMsg, QStringLiteral("Raw"));
+    logger()->enableLogToConsole();
+
+    // Oldest message is dropped
+    QCOMPARE(all->lines().size(), 3);
+    QVERIFY(all->lines().at(0).endsWith(QStringLiteral(": Third")));
+    QVERIFY(all->lines().at(0).contains(QStringLiteral("|info|")));
+    QCOMPARE(all->lines().at(2), QStringLiteral("Raw"));
+
+    QCOMPARE(warnings->lines().size(), 3);
+    QVERIFY(warnings->lines().at(0).endsWith(QStringLiteral(": Second")));
+
+    const QStringList expected = { QStringLiteral("debug: First"),
+                                   QStringLiteral("warning: Second"),
+                                   QStringLiteral("info: Third"),
+                                   QStringLiteral("critical: Fourth"),
+                                   QStringLiteral("Raw") };
+    QCOMPARE(shortLines->lines(), expected);
+    QCOMPARE(shortLines2->lines(), expected);
+
+    // Removed sinks are deleted by MLog
+    for (MLogSink *sink : logger()->sinks())
+        logger()->removeSink(sink);
+    QVERIFY(logger()->sinks().isEmpty());
+    qInfo() << "Not in sinks";
+
+    QFile logFile(filePath);
+    QVERIFY(logFile.open(QFile::ReadOnly | QFile::Text));
+    QCOMPARE(logFile.readLine(), QByteArray("default|First\n"));
+    QCOMPARE(logFile.readLine(), QByteArray("test.logger|Second\n"));
+    QVERIFY(!logFile.readAll().contains("Not in sinks"));
+    logFile.close();
+    QFile::remove(filePath);
+}
+
+//! Counts how many times buffered console output was written out
+class CountingConsoleSink : public MLogConsoleSink
+{
+public:
+    int writes = 0;
+
+protected:
+    void writePending() override
+    {
+        ++writes;
+        MLogConsoleSink::writePending();
+    }
+};
+
+void TestMLog::testConsoleFlushPolicy()
+{
+    QCOMPARE(logger()->consoleFlushPolicy(), MLog::ConsoleFlushPolicy::Immediate);
+    logger()->setConsoleFlushPolicy(MLog::ConsoleFlushPolicy::Interval, 50);
+    QCOMPARE(logger()->consoleFlushPolicy(), MLog::ConsoleFlushPolicy::Interval);
+    qInfo() << "Buffered console message";
+    logger()->flush();
+    logger()->setConsoleFlushPolicy(MLog::ConsoleFlushPolicy::Immediate);
+
+    CountingConsoleSink *console = new CountingConsoleSink;
+    logger()->addSink(console);
+    logger()->disableLogToConsole();
+
+    console->setFlushPolicy(MLog::ConsoleFlushPolicy::LineCount, 3);
+    console->writes = 0;
+    for (int i = 0; i < 5; ++i)
+        qInfo() << "Line" << i;
+    QCOMPARE(console->writes, 1);
+    logger()->flush();
+    QCOMPARE(console->writes, 2);
+
+    console->setFlushPolicy(MLog::ConsoleFlushPolicy::Severity);
+    console->writes = 0;
+    qDebug() << "Debug";
+    qInfo() << "Info";
+    QCOMPARE(console->writes, 0);
+    qWarning() << "Warning";
+    QCOMPARE(console->writes, 1);
+
+    logger()->removeSink(console);
+    logger()->enableLogToConsole();
+}
+
+void TestMLog::testFileDurability()
+{
+    logger()->setFilePreallocation(1024 * 1024);
+    logger()->setFileFlushPolicy(MLog::FileFlushPolicy::Buffered);
+    logger()->enableLogToFile(QCoreApplication::applicationName(),
+                              QCoreApplication::applicationDirPath());
+    const QString path = logger()->currentLogPath();
+    QCOMPARE(QFileInfo(path).size(), qint64(0));
+
+    qInfo() << "Buffered message";
+    QCOMPARE(QFileInfo(path).size(), qint64(0));
+    logger()->flush();
+    const qint64 size = QFileInfo(path).size();
+    QVERIFY(size > 0);
+
+    logger()->setSyncOnCritical(true);
+    qCritical() << "Synchronized message";
+    QVERIFY(QFileInfo(path).size() > size);
+    logger()->setSyncOnCritical(false);
+
+    logger()->setFileFlushPolicy(MLog::FileFlushPolicy::Periodic, 50);
+    const qint64 size2 = QFileInfo(path).size();
+    qInfo() << "Periodic message";
+    QTRY_VERIFY(QFileInfo(path).size() > size2);
+
+    // Preallocated space is never visible in the file
+    logger()->disableLogToFile();
+    QFile logFile(path);
+    QVERIFY(logFile.open(QFile::ReadOnly));
+    QCOMPARE(logFile.readAll().size(), QFileInfo(path).size());
+    logFile.close();
+
+    logger()->setFileFlushPolicy(MLog::FileFlushPolicy::Default);
+    logger()->setFilePreallocation(0);
+    clean();
+}
+
+void TestMLog::testFlightRecorder()
+{
+    logger()->setLogLevel(MLog::WarningLog);
+    logger()->enableFlightRecorder(3);
+    QVERIFY(logger()->isFlightRecorder());
+    logger()->enableLogToFile(QCoreApplication::applicationName(),
+                              QCoreApplication::applicationDirPath());
+
+    qDebug() << "Recorded 1";
+    qCDebug(testLogger) << "Recorded 2";
+    qInfo() << "Recorded 3";
+    qWarning() << "Recorded 4";
+    logger()->flush();
+
+    QFile logFile(logger()->currentLogPath());
+    QVERIFY(logFile.open(QFile::ReadOnly | QFile::Text));
+    QByteArray content = logFile.readAll();
+    QVERIFY(!content.contains("Recorded 3"));
+    QVERIFY(content.contains("Recorded 4"));
+
+    // Same size, recorded messages are kept
+    logger()->enableFlightRecorder(3);
+    logger()->dumpFlightRecorder();
+    content += logFile.readAll();
+    logFile.close();
+    const int dump = content.indexOf("--- Flight recorder");
+    QVERIFY(dump > 0);
+    // Only the last 3 messages are kept
+    QVERIFY(!content.contains("Recorded 1"));
+    QVERIFY(content.indexOf("Recorded 2") > dump);
+    QVERIFY(content.indexOf("Recorded 3") > dump);
+    QVERIFY(content.lastIndexOf("Recorded 4") > dump);
+    QVERIFY(content.contains("--- End of flight recorder ---"));
+
+    logger()->disableFlightRecorder();
+    QVERIFY(!logger()->isFlightRecorder());
+    logger()->setLogLevel(MLog::DebugLog);
+    clean();
+}
+
+void TestMLog::testRateLimit()
+{
+    MemorySinkScope sink(QStringLiteral("%{message}"));
+    const quint64 suppressedBefore = logger()->suppressedMessageCount();
+
+    logger()->enableRateLimit(1, 3, MLog::RateLimitScope::Category);
+    QVERIFY(logger()->isRateLimit());
+    for (int i = 0; i < 10; ++i)
+        qCWarning(testLogger) << "Limited" << i;
+    qInfo() << "Other category";
+    QCOMPARE(sink->lines(), QStringList({ QStringLiteral("Limited 0"),
+                                          QStringLiteral("Limited 1"),
+                                          QStringLiteral("Limited 2"),
+                                          QStringLiteral("Other category") }));
+    QCOMPARE(logger()->suppressedMessageCount() - suppressedBefore, quint64(7));
+
+    // Bucket is refilled
+    QTest::qWait(1100);
+    sink->clear();
+    qCWarning(testLogger) << "Passed";
+    QCOMPARE(sink->lines(), QStringList({ QStringLiteral("Passed suppressed=7") }));
+
+    logger()->disableRateLimit();
+    QVERIFY(!logger()->isRateLimit());
+}
+
+void TestMLog::testCollapseRepeated()
+{
+    MemorySinkScope sink(QStringLiteral("%{message}"));
+
+    logger()->setCollapseRepeatedMessages(true);
+    QVERIFY(logger()->isCollapseRepeatedMessages());
+    qInfo() << "First";
+    for (int i = 0; i < 5; ++i)
+        qWarning() << "Retrying";
+    qInfo() << "Last";
+    for (int i = 0; i < 3; ++i)
+        qInfo() << "Last";
+    logger()->flush();
+
+    QCOMPARE(sink->lines(), QStringList({ QStringLiteral("First"),
+                                          QStringLiteral("Retrying"),
+                                          QStringLiteral("Last message repeated 4 times"),
+                                          QStringLiteral("Last"),
+                                          QStringLiteral("Last message repeated 3 times") }));
+}
+
+void TestMLog::testSampling()
+{
+    MemorySinkScope sink(QStringLiteral("%{type}: %{message}"));
+
+    logger()->setSampling(QStringLiteral("test.*"), MLog::DebugLog, 10);
+    for (int i = 0; i < 1000; ++i)
+        qCDebug(testLogger) << "Sampled";
+    qCWarning(testLogger) << "Not sampled";
+    qDebug() << "Other category";
+
+    const QStringList lines = sink->lines();
+    // 100 expected, random
+    QVERIFY(lines.size() > 30);
+    QVERIFY(lines.size() < 300);
+    for (int i = 0; i < lines.size() - 2; ++i)
+        QCOMPARE(lines.at(i), QStringLiteral("debug: Sampled sampled=10"));
+    QCOMPARE(lines.at(lines.size() - 2), QStringLiteral("warning: Not sampled"));
+    QCOMPARE(lines.last(), QStringLiteral("debug: Other category"));
+
+    logger()->clearSampling();
+    sink->clear();
+    qCDebug(testLogger) << "All";
+    QCOMPARE(sink->lines(), QStringList({ QStringLiteral("debug: All") }));
+}
+
+void TestMLog::testStatistics()
+{
+    logger()->setStatisticsEnabled(true);
+    QVERIFY(logger()->isStatisticsEnabled());
+    logger()->resetStatistics();
+    logger()->enableLogToFile(QCoreApplication::applicationName(),
+                              QCoreApplication::applicationDirPath());
+
+    qDebug() << "Counted 1";
+    qDebug() << "Counted 2";
+    qCWarning(testLogger) << "Counted 3";
+    // Another category of the same name
+    const QByteArray name("test.logger");
+    const QLoggingCategory sameName(name.constData());
+    qCWarning(sameName) << "Counted 4";
+    logger()->flush();
+
+    const MLogStatistics statistics = logger()->statistics();
+    QCOMPARE(statistics.messages[MLog::DebugLog], quint64(2));
+    QCOMPARE(statistics.messages[MLog::WarningLog], quint64(2));
+    QCOMPARE(statistics.totalMessages(), quint64(4));
+    QCOMPARE(statistics.categories.value(QStringLiteral("default")), quint64(2));
+    QCOMPARE(statistics.categories.value(QStringLiteral("test.logger")), quint64(2));
+    QCOMPARE(qint64(statistics.bytesWritten), QFileInfo(logger()->currentLogPath()).size());
+    QCOMPARE(statistics.writeLatency.size(), MLogStatistics::LatencyBuckets);
+    QCOMPARE(std::accumulate(statistics.writeLatency.cbegin(),
+                             statistics.writeLatency.cend(), quint64(0)), quint64(4));
+
+    const QJsonObject json = statistics.toJson();
+    QCOMPARE(json.value(QStringLiteral("messages")).toObject()
+             .value(QStringLiteral("debug")).toInt(), 2);
+
+    logger()->setStatisticsEnabled(false);
+    qDebug() << "Not counted";
+    QCOMPARE(logger()->statistics().totalMessages(), quint64(4));
+    logger()->resetStatistics();
+    QCOMPARE(logger()->statistics().totalMessages(), quint64(0));
+    clean();
+}
+
+void TestMLog::testCallSiteProfiling()
+{
+    logger()->disableLogToConsole();
+    logger()->setCallSiteProfiling(true);
+    QVERIFY(logger()->isCallSiteProfiling());
+    for (int i = 0; i < 5; ++i)
+        qCDebug(testLogger) << "Hot";
+    for (int i = 0; i < 2; ++i)
+        qCDebug(testLogger) << "Cold";
+    logger()->setCallSiteProfiling(false);
+    qCDebug(testLogger) << "Not counted";
+    logger()->enableLogToConsole();
+
+    const QVector<MLogCallSiteStatistics> top = logger()->topCallSites(1);
+    QCOMPARE(top.size(), 1);
+    QCOMPARE(top.first().category, QStringLiteral("test.logger"));
+#ifdef QT_MESSAGELOGCONTEXT
+    QCOMPARE(top.first().messages, quint64(5));
+    QCOMPARE(top.first().size, quint64(5 * 3));
+    QVERIFY(top.first().file.endsWith(QStringLiteral("tst_mlog.cpp")));
+    QVERIFY(top.first().line > 0);
+#else
+    // Without context, messages of a category are counted together
+    QCOMPARE(top.first().messages, quint64(7));
+#endif
+
+    // QML and other runtime call sites free their strings after logging
+    QByteArray file("runtime.qml");
+    QByteArray function("onClicked");
+    logger()->disableLogToConsole();
+    logger()->setCallSiteProfiling(true);
+    for (int i = 0; i < 10; ++i) {
+        QMessageLogger(file.constData(), 7, function.constData(), "test.logger").debug()
+                << "Runtime";
+    }
+    logger()->setCallSiteProfiling(false);
+    logger()->enableLogToConsole();
+    file.fill('x');
+    function.fill('x');
+
+    const MLogCallSiteStatistics runtime = logger()->topCallSites(1).first();
+    QCOMPARE(runtime.messages, quint64(10));
+    QCOMPARE(runtime.file, QStringLiteral("runtime.qml"));
+    QCOMPARE(runtime.function, QStringLiteral("onClicked"));
+}
+
+void TestMLog::testFormattedLogging()
+{
+    MemorySinkScope sink(QStringLiteral("%{type}: %{category}: %{message}"));
+
+    mlog::info(testLogger, "x={} y={}", 1, 2.5);
+    mlog::debug(testLogger(), "{} {} {} {} {}", true, 'c', -42, 42u, 0.1f);
+    mlog::warning(testLogger, "{} {} {} {}", "\xc5\xbc", QStringLiteral("\u0105"),
+                  QByteArray("bytes"), std::string("std"));
+    mlog::critical(testLogger, "{{{}}} {}", MLog::InfoLog, static_cast<void *>(nullptr));
+    mlog::info(testLogger, "Via QDebug: {}", QPoint(1, 2));
+    mlog::info(testLogger, MLOG_FORMAT("Checked {}"), QLatin1String("latin1"));
+
+    logger()->setCategoryLogLevel(QStringLiteral("test.logger"), MLog::WarningLog);
+    mlog::info(testLogger, "Filtered {}", 1);
+    logger()->clearCategoryLogLevels();
+
+    QCOMPARE(sink->lines(), QStringList({
+        QStringLiteral("info: test.logger: x=1 y=2.5"),
+        QStringLiteral("debug: test.logger: true c -42 42 0.1"),
+        QString::fromUtf8("warning: test.logger: \xc5\xbc \xc4\x85 bytes std"),
+        QStringLiteral("critical: test.logger: {4} 0x0"),
+        QStringLiteral("info: test.logger: Via QDebug: QPoint(1,2)"),
+        QStringLiteral("info: test.logger: Checked latin1")
+    }));
+}
+
+void TestMLog::testThreadBuffering()
+{
+    const QString oldPattern = logger()->messagePattern();
+    logger()->setMessagePattern(QStringLiteral("%{message}"));
+    logger()->enableLogToFile(QCoreApplication::applicationName(),
+                              QCoreApplication::applicationDirPath());
+    // Nothing is handed off by size or time during the test
+    logger()->enableThreadBuffering(1024 * 1024, 60 * 1000);
+    QVERIFY(logger()->isThreadBuffering());
+
+    const auto contents = []() {
+        QFile logFile(logger()->currentLogPath());
+        logFile.open(QFile::ReadOnly | QFile::Text);
+        return QString::fromUtf8(logFile.readAll()).split(QLatin1Char('\n'));
+    };
+
+    qDebug() << "Buffered 1";
+    std::thread thread([]() { qInfo() << "Buffered 2"; });
+    thread.join();
+    qDebug() << "Buffered 3";
+    QVERIFY(contents().contains(QStringLiteral("Buffered 1")) == false);
+
+    // Warnings are not buffered, lines logged before them come first
+    qWarning() << "Warning";
+    QStringList lines = contents();
+    const int first = lines.indexOf(QStringLiteral("Buffered 1"));
+    QVERIFY(first >= 0);
+    QCOMPARE(lines.mid(first, 4), QStringList({ QStringLiteral("Buffered 1"),
+                                                QStringLiteral("Buffered 2"),
+                                                QStringLiteral("Buffered 3"),
+                                                QStringLiteral("Warning") }));
+
+    qDebug() << "Buffered 4";
+    QVERIFY(contents().contains(QStringLiteral("Buffered 4")) == false);
+    logger()->flush();
+    QVERIFY(contents().contains(QStringLiteral("Buffered 4")));
+
+    logger()->disableThreadBuffering();
+    QVERIFY(!logger()->isThreadBuffering());
+    qDebug() << "Direct";
+    QVERIFY(contents().contains(QStringLiteral("Direct")));
+
+    logger()->setMessagePattern(oldPattern);
+    clean();
+}
+
+void TestMLog::testRuntimeRotation()
+{
+    const QString directory = QCoreApplication::applicationDirPath();
+    const QString appName = QStringLiteral("Rotation log");
+    const QDir logsDir(directory);
+    const qint64 maxFileSize = 2000;
+    logger()->setLogRotation(MLog::RotationType::Consequent, 3, maxFileSize);
+    logger()->enableLogToFile(appName, directory);
+
+    const int messageCount = 100;
+    for (int i = 0; i < messageCount; ++i)
+        qInfo() << "Rotation message" << i;
+    logger()->disableLogToFile();
+
+    // Older logs are renamed in the background
+    const QStringList rotatedFilter(appName + "-rotated-*");
+    QTRY_VERIFY(logsDir.entryList(rotatedFilter, QDir::Files).isEmpty());
+
+    const QStringList paths = {
+        directory + '/' + appName + "-previous-1.log",
+        logger()->previousLogPath(),
+        logger()->currentLogPath()
+    };
+    QVERIFY(!QFile::exists(directory + '/' + appName + "-previous-2.log"));
+
+    // Every file holds whole messages, in order, with nothing lost in between
+    const QRegularExpression expr(QStringLiteral("Rotation message (\\d+)\n"));
+    int expected = -1;
+    for (const QString &path : paths) {
+        QFile logFile(path);
+        QVERIFY(logFile.open(QFile::ReadOnly | QFile::Text));
+        QVERIFY(logFile.size() <= maxFileSize);
+        while (!logFile.atEnd()) {
+            const QString line = QString::fromUtf8(logFile.readLine());
+            const QRegularExpressionMatch match = expr.match(line);
+            QVERIFY2(match.hasMatch(), qPrintable(line));
+            const int index = match.captured(1).toInt();
+            if (expected >= 0)
+                QCOMPARE(index, expected);
+            expected = index + 1;
+        }
+    }
+    QCOMPARE(expected, messageCount);
+
+    QFile::remove(paths.first());
+    clean();
+
+    // Age limit, DateTime rotation
+    logger()->setLogRotation(MLog::RotationType::DateTime, 3, 0, 1);
+    logger()->enableLogToFile(appName, directory);
+    const QString firstLogPath = logger()->currentLogPath();
+    qInfo() << "First file";
+    QTest::qWait(1100);
+    qInfo() << "Second file";
+    QVERIFY(logger()->currentLogPath() != firstLogPath);
+    QCOMPARE(logger()->previousLogPath(), firstLogPath);
+    logger()->disableLogToFile();
+    QFile::remove(firstLogPath);
+    clean();
+
+    logger()->setLogRotation(MLog::RotationType::Consequent, 2);
+}
+
+void TestMLog::testRotationManifest()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString appName = QStringLiteral("Manifest log");
+    const auto readLog = [&](const QString &suffix) {
+        QFile logFile(directory.filePath(appName + suffix));
+        return logFile.open(QFile::ReadOnly) ? logFile.readAll() : QByteArray();
+    };
+
+    logger()->setLogRotation(MLog::RotationType::Consequent, 3);
+    for (int run = 0; run < 5; ++run) {
+        if (run == 4) {
+            // Corrupt manifest is rebuilt from directory contents
+            QFile manifest(directory.filePath(appName + ".manifest"));
+            QVERIFY(manifest.open(QFile::WriteOnly | QFile::Truncate));
+            manifest.write("{ not json");
+        }
+
+        logger()->enableLogToFile(appName, directory.path());
+        qInfo() << "Run" << run;
+        logger()->disableLogToFile();
+    }
+
+    QVERIFY(readLog("-current.log").contains("Run 4"));
+    QVERIFY(readLog("-previous.log").contains("Run 3"));
+    QVERIFY(readLog("-previous-1.log").contains("Run 2"));
+    QVERIFY(!QFile::exists(directory.filePath(appName + "-previous-2.log")));
+
+    QFile manifest(directory.filePath(appName + ".manifest"));
+    QVERIFY(manifest.open(QFile::ReadOnly));
+    const QJsonObject object = QJsonDocument::fromJson(manifest.readAll()).object();
+    QCOMPARE(object.value("current").toString(), QString(appName + "-current.log"));
+    const QStringList logs = {
+        QString(appName + "-previous.log"),
+        QString(appName + "-previous-1.log")
+    };
+    QCOMPARE(object.value("logs").toVariant().toStringList(), logs);
+
+    // Logs rotated at runtime, but left behind by a process which exited
+    // before moving them into the set, are picked up on next start
+    const auto writeLog = [&](const QString &suffix, const QByteArray &contents) {
+        QFile logFile(directory.filePath(appName + suffix));
+        return logFile.open(QFile::WriteOnly) && logFile.write(contents) > 0;
+    };
+    QVERIFY(writeLog("-rotated-100-2.log", "Rotated second"));
+    QVERIFY(writeLog("-rotated-99-7.log", "Rotated first"));
+    logger()->setLogRotation(MLog::RotationType::Consequent, 4);
+    logger()->enableLogToFile(appName, directory.path());
+    logger()->disableLogToFile();
+    logger()->setLogRotation(MLog::RotationType::Consequent, 2);
+
+    QVERIFY(readLog("-previous.log").contains("Run 4"));
+    QCOMPARE(readLog("-previous-1.log"), QByteArray("Rotated second"));
+    QCOMPARE(readLog("-previous-2.log"), QByteArray("Rotated first"));
+    QVERIFY(!QFile::exists(directory.filePath(appName + "-previous-3.log")));
+    QVERIFY(!QFile::exists(directory.filePath(appName + "-rotated-100-2.log")));
+    QVERIFY(!QFile::exists(directory.filePath(appName + "-rotated-99-7.log")));
+}
+
+void TestMLog::testGzip()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QByteArray data;
+    for (int i = 0; i < 20000; ++i)
+        data += "Compressed log line number " + QByteArray::number(i) + '\n';
+
+    const QString source = directory.filePath("source.log");
+    const QString target = directory.filePath("source.log.gz");
+    QFile sourceFile(source);
+    QVERIFY(sourceFile.open(QFile::WriteOnly));
+    sourceFile.write(data);
+    sourceFile.close();
+
+    QVERIFY(mlog::gzipFile(source, target, 6, nullptr));
+    QFile targetFile(target);
+    QVERIFY(targetFile.open(QFile::ReadOnly));
+    const QByteArray gzip = targetFile.readAll();
+
+    // gzip header, the same deflate data as zlib produces, input size
+    const QByteArray zlib = qCompress(data, 6);
+    QVERIFY(gzip.startsWith("\x1f\x8b\x08"));
+    QCOMPARE(gzip.mid(10, gzip.size() - 18), zlib.mid(6, zlib.size() - 10));
+    QCOMPARE(qFromLittleEndian<quint32>(gzip.constData() + gzip.size() - 4),
+             quint32(data.size()));
+}
+
+void TestMLog::testLogCompression()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString appName = QStringLiteral("Compressed log");
+
+    logger()->setLogRotation(MLog::RotationType::Consequent, 3);
+    logger()->enableLogCompression(9);
+    for (int run = 0; run < 3; ++run) {
+        logger()->enableLogToFile(appName, directory.path());
+        qInfo() << "Run" << run;
+    }
+
+    QTRY_VERIFY(logger()->previousLogPath().endsWith(".gz"));
+    logger()->disableLogToFile();
+    logger()->disableLogCompression();
+    logger()->setLogRotation(MLog::RotationType::Consequent, 2);
+
+    const QDir logsDir(directory.path());
+    QCOMPARE(logsDir.entryList({ appName + "-previous*" }, QDir::Files, QDir::Name),
+             QStringList({ QString(appName + "-previous-1.log.gz"),
+                           QString(appName + "-previous.log.gz") }));
+
+    QFile previous(logger()->previousLogPath());
+    QVERIFY(previous.open(QFile::ReadOnly));
+    QVERIFY(previous.read(2) == "\x1f\x8b");
+}
+
+void TestMLog::benchmarkFileWrite_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::newRow("QTextStream per message") << true;
+    QTest::newRow("persistent UTF-8 buffer") << false;
+}
+
+/*!
+ * Each iteration writes 1000 messages of 64 bytes (64000 bytes), divide by
+ * the reported time to get bytes/sec. "QTextStream per message" is how
+ * MLog::write() used to work.
+ */
+void TestMLog::benchmarkFileWrite()
+{
+    QFETCH(bool, legacy);
+    const int messageCount = 1000;
+    const QString message = QStringLiteral(
+        "2026-01-01T12:00:00|info|bench|benchmarkFileWrite: 0123456789\n");
+    QCOMPARE(message.size(), 64);
+
+    if (legacy) {
+        QFile file(QCoreApplication::applicationDirPath() + "/Benchmark legacy.log");
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        QBENCHMARK {
+            for (int i = 0; i < messageCount; ++i) {
+                QTextStream stream(&file);
+#if QT_VERSION >= 0x060000
+                stream.setEncoding(QStringConverter::Utf8);
+#else
+                stream.setCodec("UTF-8");
+#endif
+                stream << message;
+            }
+        }
+        file.close();
+        file.remove();
+    } else {
+        logger()->enableLogToFile("Benchmark",
+                                  QCoreApplication::applicationDirPath());
+        // writeRaw() prints to console only when level allows it
+        const MLog::LogLevel level = logger()->logLevel();
+        logger()->setLogLevel(MLog::NoLog);
+        QBENCHMARK {
+            for (int i = 0; i < messageCount; ++i)
+                logger()->writeRaw(QtInfoMsg, message);
+        }
+        logger()->setLogLevel(level);
+        clean();
+    }
+}
+
+void TestMLog::benchmarkTimestamp_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::addColumn<int>("source");
+    QTest::newRow("QDateTime per message") << true << int(MLog::ClockSource::System);
+    QTest::newRow("cached, system clock") << false << int(MLog::ClockSource::System);
+    QTest::newRow("cached, coarse clock") << false << int(MLog::ClockSource::Coarse);
+    QTest::newRow("cached, monotonic clock") << false << int(MLog::ClockSource::Monotonic);
+}
+
+/*!
+ * Each iteration timestamps and renders 1000 messages with millisecond
+ * precision. "QDateTime per message" is what qFormatLogMessage() does.
+ */
+void TestMLog::benchmarkTimestamp()
+{
+    QFETCH(bool, legacy);
+    QFETCH(int, source);
+    const int messageCount = 1000;
+    const QString format = QStringLiteral("yyyy-MM-dd HH:mm:ss.zzz");
+    QByteArray out;
+    out.reserve(64);
+
+    if (legacy) {
+        QBENCHMARK {
+            for (int i = 0; i < messageCount; ++i) {
+                out.resize(0);
+                out.append(QDateTime::currentDateTime().toString(format).toUtf8());
+            }
+        }
+    } else {
+        const MLogFormatter formatter("%{time " + format + "}");
+        MLogMessage message;
+        QBENCHMARK {
+            for (int i = 0; i < messageCount; ++i) {
+                out.resize(0);
+                message.timestamp = MLogClock::now(MLog::ClockSource(source));
+                formatter.format(out, message);
+            }
+        }
+    }
+
+    QVERIFY(out.size() > 0);
+}
+
+void TestMLog::benchmarkEnableLogToFile_data()
+{
+    QTest::addColumn<bool>("background");
+    QTest::newRow("blocking rotation") << false;
+    QTest::newRow("background rotation") << true;
+}
+
+/*!
+ * Measures application startup latency: time spent in enableLogToFile() in a
+ * directory holding 2000 other log files.
+ */
+void TestMLog::benchmarkEnableLogToFile()
+{
+    QFETCH(bool, background);
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    for (int i = 0; i < 2000; ++i) {
+        QFile file(directory.filePath(QString("Other app " + QString::number(i)
+                                              + "-current.log")));
+        QVERIFY(file.open(QFile::WriteOnly));
+    }
+
+    const QString appName = QStringLiteral("Startup log");
+    logger()->setBackgroundRotation(background);
+    QBENCHMARK {
+        logger()->enableLogToFile(appName, directory.path());
+    }
+    logger()->setBackgroundRotation(false);
+
+    // Waits for background rotation
+    logger()->enableLogToFile(appName, directory.path());
+    QVERIFY(QFile::exists(logger()->previousLogPath()));
+    QVERIFY(!QFile::exists(directory.filePath(appName + "-previous-1.log")));
+    QCOMPARE(QDir(directory.path()).entryList({ appName + "-rotated-*" },
+                                             QDir::Files).size(), 0);
+    logger()->disableLogToFile();
+}
+
 QTEST_MAIN(TestMLog)
 
 #include "tst_mlog.moc"